@@ -0,0 +1,37 @@
+/*
+This sketch streams every radar frame to the serial port as a compact binary packet:
+raw distance and status of each sensor, filtered distance and angle, with a sequence
+number and a CRC. One packet of a 9 sensor array is 38 bytes, written with a single
+write() call, so logging does not slow down the radar.
+
+Decode the stream on the host with extras/fuzzy_radar_decode.py, e.g.
+	python3 fuzzy_radar_decode.py /dev/ttyUSB0 115200
+
+
+*/
+
+
+#include "Fuzzy_Radar.h"
+
+const uint8_t NumberOfSensors = 9;
+const uint8_t XshutnControlPin = 2;
+const float SeperationDegrees = 10;
+
+
+FuzzyRadar radar(NumberOfSensors);
+
+
+void setup()
+{
+	Serial.begin(115200);
+
+	//Nothing else should be printed to Serial, the decoder skips anything that is not a valid packet.
+	radar.setBinaryOutput(&Serial);
+	radar.begin(XshutnControlPin, SeperationDegrees);
+}
+
+void loop()
+{
+	radar.update(); //Frames are written from inside update().
+	radar.clearAvailableFlag();
+}
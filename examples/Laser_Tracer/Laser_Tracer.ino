@@ -30,6 +30,9 @@ void setup()
 	//Two values: XshutnControlPin and SeperationDegrees need to be provided in the begin() function.
 	radar.begin(XshutnControlPin, SeperationDegrees);
 
+	//Spread the sensor sweep over many update() calls so the servo loop is never stalled by a full I2C sweep.
+	radar.setReadMode(FuzzyRadar::READ_MODE_NON_BLOCKING);
+
 	yawServo.attach(YawServoPin);
 
 	pitchServo.attach(PitchServoPin);
@@ -45,8 +48,9 @@ void loop()
 	{
 		if (radar.getDistanceMM() > 0)
 		{
-			uint16_t distance = radar.getDistanceMM();
-			int16_t angle = radar.getAngleDegree();
+			//Aim where the target will be at the next radar frame, so the servos lead the target instead of trailing it.
+			uint16_t distance = radar.getPredictedDistanceMM();
+			int16_t angle = radar.getPredictedAngleDegree();
 			uint16_t yawValue = map(angle, -40, 40, 2000,900); //This mapping needs some trial-and-error for your servo
 			yawServo.writeMicroseconds(yawValue);
 
@@ -60,16 +64,21 @@ void loop()
 				distance = 100;
 			}
 
-			float tiltDegree = atan(float(LaserJointHeightMM) / (float)(distance)) * 57.3;
-			uint16_t pitchValue = map(tiltDegree, 10, 90, 1300, 700);  //This mapping needs some trial-and-error for your servo as well
+			//Fixed-point table lookup from the library, no float atan() in the loop.
+			int16_t tiltDecidegree = FuzzyRadar::atan2Decidegree(LaserJointHeightMM, distance);
+			uint16_t pitchValue = map(tiltDecidegree, 100, 900, 1300, 700);  //This mapping needs some trial-and-error for your servo as well
 			pitchServo.writeMicroseconds(pitchValue);
 
-			//Output data to serial window
+			//Output data to serial window. x/y is the target position (mm) in front of the radar.
 			Serial.print(distance);
 			Serial.print(" ");
 			Serial.print(angle);
 			Serial.print(" ");
-			Serial.print(tiltDegree);
+			Serial.print(tiltDecidegree);
+			Serial.print(" ");
+			Serial.print(radar.getXMM());
+			Serial.print(" ");
+			Serial.print(radar.getYMM());
 			Serial.println();
 
 			digitalWrite(LaserControlPin, HIGH); //Turn on the laser head
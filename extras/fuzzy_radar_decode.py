@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Decoder for the binary frame output of FuzzyRadar::setBinaryOutput().
+
+Usage:
+    fuzzy_radar_decode.py /dev/ttyUSB0 [baud]   read from a serial port (needs pyserial)
+    fuzzy_radar_decode.py capture.bin           read from a file
+    fuzzy_radar_decode.py -                     read from stdin
+
+Prints one line per frame. Packets with a bad CRC are skipped and the decoder
+resynchronizes on the next sync word. Gaps in the sequence number are reported.
+"""
+
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+HEADER = struct.Struct("<HIB")  # sequence, timestamp, number of sensors
+RESULT = struct.Struct("<hH")  # angle (0.1 degree), distance (mm)
+# SAMPLE_STATUS_*: valid, no reading, bus error, missing,
+# signal fail, phase fail, device error, low confidence
+STATUS_NAMES = {0: "", 1: "-", 2: "E", 3: "?", 4: "s", 5: "p", 6: "d", 7: "c"}
+
+
+def frame_size(sensors):
+    return 15 + 2 * sensors + (sensors + 1) // 2
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as FuzzyRadar::crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def decode(buffer):
+    """Decodes every complete packet in buffer (a bytearray), consuming it.
+    Yields (sequence, timestamp_ms, distances, statuses, angle_degrees, distance_mm)."""
+    while True:
+        start = buffer.find(SYNC)
+        if start < 0:
+            del buffer[:max(0, len(buffer) - 1)]
+            return
+        del buffer[:start]
+        if len(buffer) < 2 + HEADER.size:
+            return
+        sequence, timestamp, sensors = HEADER.unpack_from(buffer, 2)
+        size = frame_size(sensors)
+        if len(buffer) < size:
+            return
+
+        (crc,) = struct.unpack_from("<H", buffer, size - 2)
+        if crc16(buffer[2:size - 2]) != crc:
+            del buffer[:1]  # not a real sync word, or a corrupted packet
+            continue
+
+        offset = 2 + HEADER.size
+        distances = struct.unpack_from("<%dH" % sensors, buffer, offset)
+        offset += 2 * sensors
+        statuses = [(buffer[offset + index // 2] >> (4 * (index & 1))) & 0x0F for index in range(sensors)]
+        angle, distance = RESULT.unpack_from(buffer, size - 6)
+        del buffer[:size]
+        yield sequence, timestamp, distances, statuses, angle / 10.0, distance
+
+
+def open_source(argv):
+    if len(argv) < 2 or argv[1] == "-":
+        return sys.stdin.buffer
+    if argv[1].startswith("/dev/") or argv[1].upper().startswith("COM"):
+        import serial  # pyserial
+
+        return serial.Serial(argv[1], int(argv[2]) if len(argv) > 2 else 115200, timeout=0.1)
+    return open(argv[1], "rb")
+
+
+def main(argv):
+    source = open_source(argv)
+    buffer = bytearray()
+    expected_sequence = None
+    while True:
+        chunk = source.read(256)
+        if not chunk:
+            if hasattr(source, "in_waiting"):
+                continue  # serial port timeout, keep waiting
+            break
+        buffer += chunk
+        for sequence, timestamp, distances, statuses, angle, distance in decode(buffer):
+            if expected_sequence is not None and sequence != expected_sequence:
+                print("# %d frame(s) lost" % ((sequence - expected_sequence) & 0xFFFF))
+            expected_sequence = (sequence + 1) & 0xFFFF
+            samples = " ".join("%4d%s" % (d, STATUS_NAMES.get(s, "!")) for d, s in zip(distances, statuses))
+            print("%5d %8d [%s] distance=%d angle=%.1f" % (sequence, timestamp, samples, distance, angle))
+
+
+if __name__ == "__main__":
+    main(sys.argv)
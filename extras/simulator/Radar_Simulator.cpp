@@ -0,0 +1,423 @@
+/*
+ Name:		Radar_Simulator.cpp
+ Host simulator for FuzzyRadar, see Radar_Simulator.h.
+*/
+
+#include "Radar_Simulator.h"
+
+uint64_t simulatedMicros = 0;
+HardwareSerial Serial;
+TwoWire Wire;
+TwoWire Wire1;
+
+std::vector<SimulatedVL53L0X *> simulatedSensors;
+std::vector<SimulatedMultiplexer *> simulatedMultiplexers;
+
+static std::vector<std::pair<TwoWire *, SimulatedDevice *> > devices;
+static SimulatedScene scene;
+static SimulatedResultHook resultHook;
+static std::vector<std::pair<uint64_t, std::vector<uint16_t> > > replay;
+static bool xshutLevel = LOW;
+
+static void updateChain();
+
+//------------------------------------------------------------------------------------------------ bus
+
+void attachDevice(TwoWire *bus, SimulatedDevice *device)
+{
+	devices.push_back(std::make_pair(bus, device));
+}
+
+TwoWire::TwoWire()
+{
+	bytes = 0;
+	transactions = 0;
+	address = 0;
+	transmitLength = 0;
+	receiveLength = 0;
+	receiveIndex = 0;
+}
+
+void TwoWire::beginTransmission(uint8_t _address)
+{
+	address = _address;
+	transmitLength = 0;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+	if (transmitLength >= SIMULATED_BUFFER_LENGTH) return 0;
+	transmitBuffer[transmitLength++] = value;
+	return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+	(void)sendStop;
+	charge(transmitLength);
+	SimulatedDevice *device = findDevice(address);
+	if (device == NULL) return 2; //NACK on address
+	device->receive(transmitBuffer, transmitLength);
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t _address, uint8_t quantity, uint8_t sendStop)
+{
+	(void)sendStop;
+	if (quantity > SIMULATED_BUFFER_LENGTH) quantity = SIMULATED_BUFFER_LENGTH;
+	charge(quantity);
+	receiveIndex = 0;
+	receiveLength = 0;
+	SimulatedDevice *device = findDevice(_address);
+	if (device == NULL) return 0;
+	receiveLength = device->transmit(receiveBuffer, quantity);
+	return receiveLength;
+}
+
+int TwoWire::available()
+{
+	return receiveLength - receiveIndex;
+}
+
+int TwoWire::read()
+{
+	if (receiveIndex >= receiveLength) return -1;
+	return receiveBuffer[receiveIndex++];
+}
+
+void TwoWire::charge(uint8_t length)
+{
+	transactions++;
+	bytes += length + 1;
+	simulatedMicros += SIMULATED_TRANSACTION_TIME((uint64_t)length);
+}
+
+SimulatedDevice *TwoWire::findDevice(uint8_t _address)
+{
+	SimulatedDevice *found = NULL;
+	for (size_t index = 0; index < devices.size(); index++)
+	{
+		if ((devices[index].first != this) || (devices[index].second->acknowledge(_address) == false)) continue;
+		if (found != NULL)
+		{
+			//Two devices driving the bus at once is a bug in the address plan, not a recoverable error.
+			fprintf(stderr, "simulator: I2C address collision at 0x%02X\n", _address);
+			abort();
+		}
+		found = devices[index].second;
+	}
+	return found;
+}
+
+//------------------------------------------------------------------------------------------------ GPIO
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin != SIMULATED_XSHUT_PIN) return;
+	xshutLevel = value;
+	updateChain();
+}
+
+/*
+XSHUT of the first sensor is the host pin (low = enabled). Each following XSHUT is driven by
+GPIO1 of the previous sensor, which FuzzyRadar configures through GPIO_HV_MUX_ACTIVE_HIGH (0x84).
+*/
+static void updateChain()
+{
+	bool enable = (xshutLevel == LOW);
+	for (size_t index = 0; index < simulatedSensors.size(); index++)
+	{
+		SimulatedVL53L0X *sensor = simulatedSensors[index];
+		if (enable != sensor->enabled)
+		{
+			sensor->enabled = enable;
+			sensor->reset();
+		}
+		enable = sensor->gpioEnablesNext();
+	}
+}
+
+void resetSimulator()
+{
+	for (size_t index = 0; index < devices.size(); index++) delete devices[index].second;
+	devices.clear();
+	simulatedSensors.clear();
+	simulatedMultiplexers.clear();
+	scene = SimulatedScene();
+	resultHook = SimulatedResultHook();
+	replay.clear();
+	xshutLevel = LOW;
+	simulatedMicros = 0;
+	Wire = TwoWire();
+	Wire1 = TwoWire();
+}
+
+void createSensorChain(uint8_t _count, TwoWire *_bus)
+{
+	for (uint8_t count = 0; count < _count; count++)
+	{
+		SimulatedVL53L0X *sensor = new SimulatedVL53L0X(simulatedSensors.size());
+		simulatedSensors.push_back(sensor);
+		attachDevice(_bus, sensor);
+	}
+}
+
+SimulatedMultiplexer *createMultiplexer(uint8_t _address, uint8_t _sensorsPerChannel, TwoWire *_bus)
+{
+	SimulatedMultiplexer *multiplexer = new SimulatedMultiplexer(_address);
+	simulatedMultiplexers.push_back(multiplexer);
+	attachDevice(_bus, multiplexer);
+	for (size_t index = 0; index < simulatedSensors.size(); index++)
+	{
+		simulatedSensors[index]->channel = index / _sensorsPerChannel;
+	}
+	return multiplexer;
+}
+
+//------------------------------------------------------------------------------------------------ scene
+
+void setScene(SimulatedScene _scene)
+{
+	scene = _scene;
+}
+
+void setResultHook(SimulatedResultHook _hook)
+{
+	resultHook = _hook;
+}
+
+static uint16_t replayScene(uint8_t sensor, uint64_t us)
+{
+	size_t step = 0;
+	while ((step + 1 < replay.size()) && (replay[step + 1].first <= us)) step++;
+	if (replay.empty() || (sensor >= replay[step].second.size())) return SIMULATED_NO_RETURN;
+	return replay[step].second[sensor];
+}
+
+bool loadScene(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return false;
+	replay.clear();
+	char line[1024];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char *cursor = line;
+		while ((*cursor == ' ') || (*cursor == '\t')) cursor++;
+		if ((*cursor == '#') || (*cursor == '\n') || (*cursor == '\0')) continue;
+		char *end;
+		double timeMS = strtod(cursor, &end);
+		if (end == cursor) continue;
+		std::vector<uint16_t> distances;
+		for (cursor = end; ; cursor = end)
+		{
+			long value = strtol(cursor, &end, 10);
+			if (end == cursor) break;
+			distances.push_back(((value <= 0) || (value > SIMULATED_NO_RETURN)) ? SIMULATED_NO_RETURN : value);
+		}
+		replay.push_back(std::make_pair((uint64_t)(timeMS * 1000), distances));
+	}
+	fclose(file);
+	scene = replayScene;
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------ VL53L0X
+
+SimulatedVL53L0X::SimulatedVL53L0X(uint8_t _index)
+{
+	index = _index;
+	enabled = false;
+	channel = -1;
+	rangingTime = SIMULATED_RANGING_TIME;
+	interruptClears = 0;
+	resultReads = 0;
+	oldestSampleCleared = 0;
+	reset();
+}
+
+void SimulatedVL53L0X::reset()
+{
+	memset(registers, 0, sizeof(registers));
+	registers[0][0x84] = 0x11; //GPIO_HV_MUX_ACTIVE_HIGH reset value, GPIO1 low
+	address = 0x29;
+	page = 0;
+	pointer = 0;
+	rangingMode = RANGING_IDLE;
+	sampleReady = false;
+	sampleTime = 0;
+	nextSample = 0;
+	period = 0;
+}
+
+bool SimulatedVL53L0X::gpioEnablesNext()
+{
+	//GPIO1 is an open drain output, released (high) when the interrupt is active low and no sample is pending.
+	uint8_t gpio = registers[0][0x84];
+	return enabled && (gpio & 0x10) && !(gpio & 0x01);
+}
+
+bool SimulatedVL53L0X::acknowledge(uint8_t _address)
+{
+	if ((enabled == false) || (_address != address)) return false;
+	if (channel < 0) return true;
+	for (size_t index = 0; index < simulatedMultiplexers.size(); index++)
+	{
+		if (simulatedMultiplexers[index]->channelMask & (1 << channel)) return true;
+	}
+	return false;
+}
+
+void SimulatedVL53L0X::receive(const uint8_t *buffer, uint8_t length)
+{
+	update();
+	if (length == 0) return;
+	pointer = buffer[0];
+	for (uint8_t offset = 1; offset < length; offset++)
+	{
+		uint8_t reg = buffer[0] + offset - 1;
+		uint8_t value = buffer[offset];
+		if (reg == 0xFF)
+		{
+			page = value & 0x07;
+			continue;
+		}
+		registers[page][reg] = value;
+		if (page != 0) continue;
+		if (reg == 0x8A) address = value & 0x7F; //I2C_SLAVE_DEVICE_ADDRESS
+		if ((reg == 0x0B) && (value & 0x01)) //SYSTEM_INTERRUPT_CLEAR
+		{
+			if (sampleReady && (simulatedMicros - sampleTime > oldestSampleCleared)) oldestSampleCleared = simulatedMicros - sampleTime;
+			sampleReady = false;
+			interruptClears++;
+		}
+		if (reg == 0x00) start(value); //SYSRANGE_START
+	}
+	updateChain();
+}
+
+uint8_t SimulatedVL53L0X::transmit(uint8_t *buffer, uint8_t length)
+{
+	update();
+	resultReads++;
+	for (uint8_t offset = 0; offset < length; offset++)
+	{
+		uint8_t reg = pointer + offset;
+		uint8_t value = registers[page][reg];
+		if ((page == 0) && (reg == 0x13)) value = sampleReady ? 0x04 : 0x00; //RESULT_INTERRUPT_STATUS, new sample ready
+		if (reg == 0x83) value = 0x01; //stop_variable and SPAD info handshakes
+		if (reg == 0x92) value = 0x85; //SPAD count 5, aperture
+		if ((page == 0) && (reg == 0x91)) value = 0x3C; //stop_variable
+		buffer[offset] = value;
+	}
+	return length;
+}
+
+void SimulatedVL53L0X::start(uint8_t mode)
+{
+	if (mode & 0x01)
+	{
+		//Single shot. SYSTEM_SEQUENCE_CONFIG 0x01/0x02 selects a VHV or phase calibration run.
+		bool calibration = (registers[0][0x01] == 0x01) || (registers[0][0x01] == 0x02);
+		rangingMode = RANGING_SINGLE;
+		sampleReady = false;
+		nextSample = simulatedMicros + (calibration ? SIMULATED_CALIBRATION_TIME : rangingTime);
+		latchResult(nextSample);
+	}
+	else if (mode == 0x02)
+	{
+		//Back-to-back continuous
+		rangingMode = RANGING_CONTINUOUS;
+		period = rangingTime;
+		nextSample = simulatedMicros + rangingTime;
+	}
+	else if (mode == 0x04)
+	{
+		//Timed continuous, SYSTEM_INTERMEASUREMENT_PERIOD is in oscillator ticks (OSC_CALIBRATE_VAL per ms).
+		uint32_t ticks = ((uint32_t)registers[0][0x04] << 24) | ((uint32_t)registers[0][0x05] << 16)
+			| ((uint32_t)registers[0][0x06] << 8) | registers[0][0x07];
+		uint16_t oscillator = ((uint16_t)registers[0][0xF8] << 8) | registers[0][0xF9];
+		if (oscillator != 0) ticks /= oscillator;
+		period = (ticks * 1000 > rangingTime) ? ticks * 1000 : rangingTime;
+		rangingMode = RANGING_CONTINUOUS;
+		nextSample = simulatedMicros + rangingTime;
+	}
+	else
+	{
+		rangingMode = RANGING_IDLE;
+	}
+}
+
+void SimulatedVL53L0X::update()
+{
+	if ((rangingMode == RANGING_SINGLE) && (sampleReady == false) && (simulatedMicros >= nextSample))
+	{
+		sampleReady = true;
+		rangingMode = RANGING_IDLE;
+		registers[0][0x00] &= ~0x01;
+	}
+	if ((rangingMode == RANGING_CONTINUOUS) && (simulatedMicros >= nextSample))
+	{
+		//Samples that were never read are overwritten, as on the device.
+		sampleReady = true;
+		latchResult(nextSample);
+		while (nextSample <= simulatedMicros) nextSample += period;
+	}
+}
+
+void SimulatedVL53L0X::latchResult(uint64_t _sampleTime)
+{
+	sampleTime = _sampleTime;
+	uint16_t range = scene ? scene(index, sampleTime) : SIMULATED_NO_RETURN;
+	if (range == 0) range = SIMULATED_NO_RETURN;
+	bool noReturn = (range >= SIMULATED_NO_RETURN);
+	//Return signal rate in Q9.7 MCPS, falling with the square of the range.
+	uint16_t signalRate = noReturn ? 0x0010 : (uint16_t)(40000000UL / ((uint32_t)range * range + 1) + 8);
+	uint8_t *result = &registers[0][0x14]; //RESULT_RANGE_STATUS
+	result[0] = noReturn ? (4 << 3) : (11 << 3); //device range status: phase fail or range valid
+	result[1] = 0;
+	result[2] = 0x05; //ambient rate
+	result[3] = 0x00;
+	result[4] = 0;
+	result[5] = 0;
+	result[6] = signalRate >> 8;
+	result[7] = signalRate;
+	result[8] = 0x00; //effective SPAD count, Q8.8
+	result[9] = 0x20;
+	result[10] = range >> 8;
+	result[11] = range;
+	if (resultHook) resultHook(index, sampleTime, result);
+}
+
+//------------------------------------------------------------------------------------------------ TCA9548A
+
+SimulatedMultiplexer::SimulatedMultiplexer(uint8_t _address)
+{
+	address = _address;
+	channelMask = 0;
+	selects = 0;
+}
+
+bool SimulatedMultiplexer::acknowledge(uint8_t _address)
+{
+	return _address == address;
+}
+
+void SimulatedMultiplexer::receive(const uint8_t *buffer, uint8_t length)
+{
+	if (length == 0) return;
+	channelMask = buffer[0];
+	selects++;
+}
+
+uint8_t SimulatedMultiplexer::transmit(uint8_t *buffer, uint8_t length)
+{
+	memset(buffer, channelMask, length);
+	return length;
+}
@@ -0,0 +1,110 @@
+/*
+ Name:		Radar_Simulator.h
+ Host simulator for FuzzyRadar: a register-level VL53L0X model, the XSHUT daisy chain,
+ a TCA9548A-style multiplexer and scene replay, on top of the simulated bus in host/Wire.h.
+ The library sources are compiled unchanged against it, see the Makefile.
+*/
+
+#ifndef _Radar_Simulator_h
+#define _Radar_Simulator_h
+
+#include <Wire.h>
+#include <vector>
+#include <functional>
+
+#define SIMULATED_NO_RETURN 8190 //Range reported when nothing is in view (mm)
+#define SIMULATED_RANGING_TIME 22000 //Time (us) of one continuous or single shot measurement
+#define SIMULATED_CALIBRATION_TIME 1500 //Time (us) of a VHV or phase calibration run
+#define SIMULATED_XSHUT_PIN 2
+
+/*
+Scene: distance (mm) seen by sensor `sensor` at time `us`. SIMULATED_NO_RETURN (or 0) when nothing is in view.
+Result hook: called with the 12 byte RESULT_RANGE_STATUS block after the model filled it in,
+so tests can overwrite the status, signal rate or SPAD count.
+*/
+typedef std::function<uint16_t(uint8_t sensor, uint64_t us)> SimulatedScene;
+typedef std::function<void(uint8_t sensor, uint64_t us, uint8_t *result)> SimulatedResultHook;
+
+class SimulatedVL53L0X : public SimulatedDevice
+{
+public:
+	SimulatedVL53L0X(uint8_t _index);
+	void reset();
+	bool acknowledge(uint8_t _address);
+	void receive(const uint8_t *buffer, uint8_t length);
+	uint8_t transmit(uint8_t *buffer, uint8_t length);
+	bool gpioEnablesNext();
+
+	uint8_t index;				//position in the scene
+	bool enabled;				//XSHUT released
+	int8_t channel;				//multiplexer channel, -1 when the sensor is directly on the bus
+	uint8_t address;
+	uint32_t rangingTime;		//us, see SIMULATED_RANGING_TIME
+	uint32_t interruptClears;
+	uint32_t resultReads;
+	uint32_t oldestSampleCleared;	//us, largest age of a sample when its interrupt was cleared
+
+private:
+	enum RangingMode { RANGING_IDLE, RANGING_SINGLE, RANGING_CONTINUOUS };
+
+	void update();
+	void start(uint8_t mode);
+	void latchResult(uint64_t _sampleTime);
+
+	uint8_t registers[8][256];	//0xFF selects the page
+	uint8_t page;
+	uint8_t pointer;
+	RangingMode rangingMode;
+	bool sampleReady;
+	uint64_t sampleTime;		//end of the measurement held in the result registers
+	uint64_t nextSample;
+	uint32_t period;
+};
+
+class SimulatedMultiplexer : public SimulatedDevice
+{
+public:
+	SimulatedMultiplexer(uint8_t _address);
+	bool acknowledge(uint8_t _address);
+	void receive(const uint8_t *buffer, uint8_t length);
+	uint8_t transmit(uint8_t *buffer, uint8_t length);
+
+	uint8_t address;
+	uint8_t channelMask;
+	uint32_t selects;
+};
+
+extern std::vector<SimulatedVL53L0X *> simulatedSensors;
+extern std::vector<SimulatedMultiplexer *> simulatedMultiplexers;
+
+//Removes every device and scene and rewinds the clock, so one program can run several setups.
+void resetSimulator();
+//Appends _count sensors to the XSHUT chain, attached to _bus. Sensors are numbered in chain order.
+void createSensorChain(uint8_t _count, TwoWire *_bus = &Wire);
+//Puts sensor k behind channel k / _sensorsPerChannel of a multiplexer at _address on _bus.
+SimulatedMultiplexer *createMultiplexer(uint8_t _address, uint8_t _sensorsPerChannel, TwoWire *_bus = &Wire);
+void setScene(SimulatedScene _scene);
+void setResultHook(SimulatedResultHook _hook);
+/*
+Replays a text scene: one line per step, "time_ms d0 d1 ... dN-1", lines starting with # are ignored.
+Each line holds until the time of the next one, sensors past the end of a line see nothing.
+Returns false if the file cannot be read.
+*/
+bool loadScene(const char *path);
+//Runs update() every _stepMicros for _durationMS of simulated time, calls _onFrame for each available frame.
+template <class Radar, class Callback> void runRadar(Radar &radar, uint32_t _durationMS, Callback _onFrame, uint16_t _stepMicros = 100)
+{
+	uint64_t end = simulatedMicros + (uint64_t)_durationMS * 1000;
+	while (simulatedMicros < end)
+	{
+		simulatedMicros += _stepMicros;
+		radar.update();
+		if (radar.available())
+		{
+			_onFrame();
+			radar.clearAvailableFlag();
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,389 @@
+/*
+ Angle accuracy of the estimators, the tracking filter, sample validation, the array geometry and
+ the Cartesian output.
+ All angles are compared with the scripted ground truth of the scene.
+*/
+
+#include "Fuzzy_Radar.h"
+#include "Radar_Simulator.h"
+#include <random>
+#include <algorithm>
+
+static double targetCentre; //sensor units, or degree for the geometry tests
+static std::mt19937 ghostRandom(1);
+static uint8_t ghostPercent;
+
+static double angleOf(double centre, uint8_t numberOfSensors)
+{
+	//Linear array at 10 degree, sensor 0 on the positive side.
+	return -(centre - (numberOfSensors - 1) / 2.0) * 10;
+}
+
+//Centre of a target sweeping across sensors 2..13 every 4 s (55 deg/s), in sensor units.
+static double sweepCentre(uint64_t us)
+{
+	double phase = fmod(us / 1e6, 4.0);
+	return (phase < 2) ? 2 + phase * 5.5 : 13 - (phase - 2) * 5.5;
+}
+
+//Return signal scaled with the beam overlap, 20 MCPS at full overlap.
+static void overlapSignal(uint8_t *result, double offset)
+{
+	uint16_t signalRate = (uint16_t)(2560 * std::max(0.02, 1.0 - offset / 1.5));
+	result[6] = signalRate >> 8;
+	result[7] = signalRate;
+}
+
+static void runEstimators()
+{
+	/*
+	Stationary target stepped across 16 x 10 deg in 0.07 sensor steps. The signal falls with the beam
+	overlap while the range barely changes, so edge sensors carry almost no range information.
+	*/
+	static const char *estimatorNames[] = { "distance centroid", "parabolic", "signal weighted", "signal per SPAD" };
+	resetSimulator();
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		double offset = fabs(sensor - targetCentre);
+		return (offset <= 1.5) ? (uint16_t)(500 + 40 * offset) : SIMULATED_NO_RETURN;
+	});
+	setResultHook([](uint8_t sensor, uint64_t us, uint8_t *result)
+	{
+		double offset = fabs(sensor - targetCentre);
+		if (offset <= 1.5) overlapSignal(result, offset);
+	});
+	FuzzyRadar radar(16);
+	radar.setFullFrameRead(true);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	for (uint8_t estimator = 0; estimator < 4; estimator++)
+	{
+		radar.setAngleEstimator((FuzzyRadar::AngleEstimator)estimator);
+		double error = 0, betweenError = 0;
+		uint32_t steps = 0, betweenSteps = 0;
+		for (targetCentre = 4.0; targetCentre < 11.0; targetCentre += 0.07)
+		{
+			runRadar(radar, 300, []() {});
+			double stepError = fabs(radar.getAngleDecidegree() / 10.0 - angleOf(targetCentre, 16));
+			error += stepError;
+			steps++;
+			double fraction = targetCentre - floor(targetCentre);
+			if ((fraction > 0.3) && (fraction < 0.7))
+			{
+				betweenError += stepError;
+				betweenSteps++;
+			}
+		}
+		printf("  %-18s mean error %.2f deg, between two sensors %.2f deg\n", estimatorNames[estimator], error / steps, betweenError / betweenSteps);
+	}
+}
+
+static void runTracking()
+{
+	//A 3-sensor target sweeping across 16 x 10 deg, with a 2-frame dropout every 1.5 s.
+	resetSimulator();
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		if (fmod(us / 1e6, 1.5) < 0.045) return SIMULATED_NO_RETURN;
+		double offset = fabs(sensor - sweepCentre(us));
+		return (offset <= 1.2) ? (uint16_t)(500 + 150 * offset) : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(16);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	double error = 0, predictionError = 0;
+	uint32_t frames = 0, emptyFrames = 0;
+	runRadar(radar, 10000, [&]()
+	{
+		if (radar.getDistanceMM() == 0)
+		{
+			emptyFrames++;
+			return;
+		}
+		if (millis() < 500) return;
+		uint64_t nextFrame = simulatedMicros + (uint64_t)radar.getFramePeriodMS() * 1000;
+		error += fabs(radar.getAngleDecidegree() / 10.0 - angleOf(sweepCentre(simulatedMicros), 16));
+		predictionError += fabs(radar.getPredictedAngleDecidegree() / 10.0 - angleOf(sweepCentre(nextFrame), 16));
+		frames++;
+	});
+	printf("  sweep at 55 deg/s: mean error %.2f deg, next-frame prediction error %.2f deg, %u empty frames\n",
+		error / frames, predictionError / frames, emptyFrames);
+}
+
+static void runValidation(bool validation)
+{
+	/*
+	3-sensor target sweeping across 16 sensors. Edge sensors of the target see a partial beam, with a weak
+	signal and a range biased towards the background. ghostPercent of the samples are phase-fail
+	wrap-around ghosts at a random close distance.
+	*/
+	resetSimulator();
+	ghostRandom.seed(1);
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		double offset = fabs(sensor - sweepCentre(us));
+		return (offset <= 1.5) ? (uint16_t)(500 + 40 * offset) : SIMULATED_NO_RETURN;
+	});
+	setResultHook([](uint8_t sensor, uint64_t us, uint8_t *result)
+	{
+		double offset = fabs(sensor - sweepCentre(us));
+		if (offset <= 1.5) overlapSignal(result, offset);
+		if (ghostRandom() % 100 < ghostPercent)
+		{
+			uint16_t ghost = 450 + ghostRandom() % 100;
+			result[0] = 6 << 3; //phase fail
+			result[6] = 0;
+			result[7] = 40;
+			result[10] = ghost >> 8;
+			result[11] = ghost;
+		}
+	});
+	FuzzyRadar radar(16);
+	if (validation) radar.setSampleValidation(true, 1.0);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	double error = 0;
+	uint32_t frames = 0, emptyFrames = 0;
+	runRadar(radar, 10000, [&]()
+	{
+		if (radar.getDistanceMM() == 0) emptyFrames++;
+		else if (millis() > 500)
+		{
+			error += fabs(radar.getAngleDecidegree() / 10.0 - angleOf(sweepCentre(simulatedMicros), 16));
+			frames++;
+		}
+	});
+	printf("  %2u%% ghosts, validation %-3s mean error %.2f deg, %u empty frames\n", ghostPercent, validation ? "on" : "off", error / frames, emptyFrames);
+}
+
+static void runLongRange(bool explicitMinimum)
+{
+	//Target at 1.5 m seen by a LONG_RANGE array: about 0.2 MCPS, above the 0.1 MCPS limit of the profile.
+	resetSimulator();
+	createSensorChain(9);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		return ((sensor >= 3) && (sensor <= 5)) ? 1500 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(9);
+	radar.setRangingProfile(FuzzyRadar::RANGING_PROFILE_LONG_RANGE);
+	if (explicitMinimum) radar.setSampleValidation(true, 0.25);
+	else radar.setSampleValidation(true);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	radar.setMaximumRangeMM(2000);
+	uint32_t frames = 0, targetFrames = 0;
+	runRadar(radar, 2000, [&]()
+	{
+		frames++;
+		if (radar.getDistanceMM() != 0) targetFrames++;
+	});
+	printf("  LONG_RANGE, target at 1.5 m, minimum signal %-13s target in %u of %u frames\n",
+		explicitMinimum ? "0.25 MCPS:" : "from profile:", targetFrames, frames);
+}
+
+static void runTargetIDs(bool adaptive)
+{
+	//Two static targets on 16 sensors, lost for one sample every 600 ms. Each should keep its first ID.
+	resetSimulator();
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		if (us % 600000 < 20000) return SIMULATED_NO_RETURN;
+		if ((sensor >= 3) && (sensor <= 5)) return 600;
+		return ((sensor >= 10) && (sensor <= 12)) ? 800 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(16);
+	radar.setMultiTargetTracking(true);
+	radar.setAdaptiveRegionOfInterest(adaptive);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	std::vector<uint8_t> ids;
+	uint32_t frames = 0, bothFrames = 0;
+	runRadar(radar, 3000, [&]()
+	{
+		frames++;
+		if (radar.getNumberOfTargets() == 2) bothFrames++;
+		for (uint8_t targetIndex = 0; targetIndex < radar.getNumberOfTargets(); targetIndex++)
+		{
+			uint8_t id = radar.getTarget(targetIndex).id;
+			if (std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+		}
+	});
+	printf("  2 static targets, %-10s %zu distinct IDs in 3 s, both targets reported in %u of %u frames\n",
+		adaptive ? "adaptive:" : "full scan:", ids.size(), bothFrames, frames);
+}
+
+static void runAzimuthTable(bool table)
+{
+	//Unevenly spaced 9-sensor array, target held on each sensor axis in turn.
+	static const float azimuth[9] = { 40, 32, 20, 12, 0, -10, -25, -30, -42 };
+	resetSimulator();
+	createSensorChain(9);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		return (fabs(azimuth[sensor] - targetCentre) <= 3) ? 600 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(9);
+	if (table) radar.begin(SIMULATED_XSHUT_PIN, azimuth);
+	else radar.begin(SIMULATED_XSHUT_PIN, 10.25f);
+	double error = 0;
+	for (uint8_t index = 0; index < 9; index++)
+	{
+		targetCentre = azimuth[index];
+		runRadar(radar, 300, []() {});
+		error += fabs(radar.getAngleDecidegree() / 10.0 - targetCentre);
+	}
+	printf("  uneven 9-sensor array, %-22s mean error %.2f deg\n", table ? "azimuth table:" : "even 10.25 deg spacing:", error / 9);
+}
+
+static void runArrayEdge(uint16_t nearDistance, uint16_t farDistance)
+{
+	/*
+	Target on the last two sensors of 9 x 10 deg, the nearer one on the edge. The distance centroid
+	(readings weighted by mean / distance, summed and divided by the count) lands past the last sensor,
+	and the angle is extrapolated along the array.
+	*/
+	static uint16_t distances[2];
+	distances[0] = farDistance;
+	distances[1] = nearDistance;
+	resetSimulator();
+	createSensorChain(9);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		return (sensor >= 7) ? distances[sensor - 7] : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(9);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	runRadar(radar, 500, []() {});
+	double mean = (farDistance + nearDistance) / 2.0;
+	double centroid = (7 * mean / farDistance + 8 * mean / nearDistance) / 2;
+	printf("  sensors 7/8 at %u/%u mm: %.1f deg, expected %.1f deg\n", farDistance, nearDistance,
+		radar.getAngleDecidegree() / 10.0, angleOf(centroid, 9));
+}
+
+static void runRingSweep()
+{
+	//16-sensor ring, 50 deg wide target circling at 40 deg/s. Sensor k points at -22.5 k deg.
+	resetSimulator();
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		double sensorAngle = fmod(360.0 - sensor * 22.5, 360.0);
+		return (fabs(fmod(sensorAngle - targetCentre + 540.0, 360.0) - 180.0) <= 25) ? 600 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(16);
+	radar.setRingGeometry(true);
+	radar.setMultiTargetTracking(true);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	int16_t previousAngle = -1;
+	uint16_t largestStep = 0, worstError = 0;
+	uint8_t firstID = 0;
+	bool stableID = true;
+	for (uint32_t step = 0; step < 40000; step++)
+	{
+		targetCentre = fmod(300.0 + step * 0.004, 360.0);
+		simulatedMicros += 100;
+		radar.update();
+		if (radar.available() == false) continue;
+		radar.clearAvailableFlag();
+		if (radar.getDistanceMM() == 0) continue;
+		int16_t angle = radar.getAngleDecidegree();
+		if (previousAngle >= 0)
+		{
+			uint16_t angleStep = abs(angle - previousAngle);
+			if (angleStep > 1800) angleStep = 3600 - angleStep;
+			largestStep = std::max(largestStep, angleStep);
+		}
+		previousAngle = angle;
+		uint16_t error = abs(angle - (int16_t)(targetCentre * 10));
+		if (error > 1800) error = 3600 - error;
+		if (step > 2000) worstError = std::max(worstError, error);
+		if (radar.getNumberOfTargets() > 0)
+		{
+			if (firstID == 0) firstID = radar.getTarget(0).id;
+			else if (radar.getTarget(0).id != firstID) stableID = false;
+		}
+	}
+	printf("  circling target: largest step %.1f deg, worst error %.1f deg, target id %s\n",
+		largestStep / 10.0, worstError / 10.0, stableID ? "stable" : "changed");
+}
+
+static void runRingCentred(uint8_t centre)
+{
+	//Symmetric 600/400/600 mm target centred on sensor `centre` of a 16-sensor ring.
+	static uint8_t centreSensor;
+	centreSensor = centre;
+	resetSimulator();
+	createSensorChain(16);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		uint8_t offset = (sensor + 16 - centreSensor) % 16;
+		if (offset == 0) return 400;
+		return ((offset == 1) || (offset == 15)) ? 600 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(16);
+	radar.setRingGeometry(true);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	runRadar(radar, 500, []() {});
+	printf("  symmetric target on sensor %2u: %.1f deg, expected %.1f deg\n", centre, radar.getAngleDecidegree() / 10.0,
+		fmod(360.0 - centre * 22.5, 360.0));
+}
+
+static void runCartesian(uint16_t mountingHeight)
+{
+	//Target at 800 mm on sensors 2 and 3 of 9 x 10 deg, so at 15 deg.
+	resetSimulator();
+	createSensorChain(9);
+	setScene([](uint8_t sensor, uint64_t us) -> uint16_t
+	{
+		return ((sensor == 2) || (sensor == 3)) ? 800 : SIMULATED_NO_RETURN;
+	});
+	FuzzyRadar radar(9);
+	radar.setMountingHeightMM(mountingHeight);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	runRadar(radar, 500, []() {});
+	double floorRange = sqrt(800.0 * 800.0 - (double)mountingHeight * mountingHeight);
+	printf("  mounting height %3u mm: %.1f deg, x/y %d/%d mm, float math %.1f/%.1f mm\n", mountingHeight,
+		radar.getAngleDecidegree() / 10.0, radar.getXMM(), radar.getYMM(),
+		floorRange * cos(15 * M_PI / 180), floorRange * sin(15 * M_PI / 180));
+}
+
+int main()
+{
+	printf("angle estimators, 16 x 10 deg, stationary target in 0.07 sensor steps\n");
+	runEstimators();
+
+	printf("tracking filter, 16 x 10 deg\n");
+	runTracking();
+
+	printf("sample validation, 16 x 10 deg\n");
+	for (ghostPercent = 0; ghostPercent <= 20; ghostPercent += 20)
+	{
+		runValidation(false);
+		runValidation(true);
+	}
+	runLongRange(true);
+	runLongRange(false);
+
+	printf("multi-target tracking, 16 x 10 deg\n");
+	runTargetIDs(false);
+	runTargetIDs(true);
+
+	printf("azimuth table\n");
+	runAzimuthTable(false);
+	runAzimuthTable(true);
+
+	printf("edge of a linear array, 9 x 10 deg\n");
+	runArrayEdge(300, 500);
+	runArrayEdge(350, 600);
+
+	printf("ring, 16 sensors\n");
+	runRingSweep();
+	runRingCentred(0);
+	runRingCentred(2);
+	runRingCentred(8);
+
+	printf("cartesian output, target at 800 mm and 15 deg\n");
+	runCartesian(0);
+	runCartesian(240);
+	return 0;
+}
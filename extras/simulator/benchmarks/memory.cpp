@@ -0,0 +1,60 @@
+/*
+ Object size and heap use of FuzzyRadar(N) and StaticFuzzyRadar<N>.
+ Host sizes: pointers are 8 bytes here and 2 bytes on AVR, so only the differences carry over.
+*/
+
+#include "Fuzzy_Radar.h"
+#include "Radar_Simulator.h"
+#include <new>
+
+static size_t heapBytes = 0;
+
+static void *allocate(size_t size)
+{
+	heapBytes += size;
+	return malloc(size);
+}
+
+__attribute__((noinline)) static void release(void *pointer)
+{
+	free(pointer);
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t size) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t size) noexcept { release(pointer); }
+
+template <uint8_t N> static void measure()
+{
+	//Heap after construction, then with the optional full frame read and binary output buffers.
+	size_t heapStart = heapBytes;
+	FuzzyRadar *radar = new FuzzyRadar(N);
+	size_t constructed = heapBytes - heapStart - sizeof(FuzzyRadar);
+	radar->setFullFrameRead(true);
+	radar->setBinaryOutput(&Serial);
+	size_t everything = heapBytes - heapStart - sizeof(FuzzyRadar);
+	delete radar;
+
+	heapStart = heapBytes;
+	FuzzyRadar *staticRadar = new StaticFuzzyRadar<N>(); //deleted through the base class
+	staticRadar->setFullFrameRead(true);
+	staticRadar->setBinaryOutput(&Serial);
+	size_t staticHeap = heapBytes - heapStart - sizeof(StaticFuzzyRadar<N>);
+	delete staticRadar;
+
+	printf("  N=%2u  FuzzyRadar: sizeof %3zu, heap %4zu (%4zu with full frame read and binary output)"
+		"  StaticFuzzyRadar<N>: sizeof %4zu, heap %zu\n",
+		N, sizeof(FuzzyRadar), constructed, everything, sizeof(StaticFuzzyRadar<N>), staticHeap);
+}
+
+int main()
+{
+	printf("host sizeof: VL53L0X %zu, RangingData %zu, pointer %zu\n", sizeof(VL53L0X), sizeof(VL53L0X::RangingData), sizeof(void *));
+	measure<5>();
+	measure<9>();
+	measure<16>();
+	return 0;
+}
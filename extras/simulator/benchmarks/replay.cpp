@@ -0,0 +1,143 @@
+/*
+ Replays a scene and prints one line per published frame: time (ms), distance (mm), angle (0.1 degree).
+ Build the simulator against two library trees (make RADAR_SRC=... BUILD=...) and diff the logs to check
+ that a change keeps the output, or to see exactly which frames it changes.
+
+ Usage: replay [scene.txt | random] [numberOfSensors] [separationDegrees] [durationMS] [reference.log]
+ "random" (the default) draws 0-2 blobs of 1-4 sensors at 100-950 mm every 25 ms, with a fixed seed.
+ With a reference log, the frames are compared with it instead of printed, and the program exits with 1
+ if the number of frames, a time or a distance differs, or an angle differs by more than
+ REPLAY_ANGLE_TOLERANCE (1 degree, the tolerance between the fixed point and float centroids).
+*/
+
+#include "Fuzzy_Radar.h"
+#include "Radar_Simulator.h"
+#include <random>
+
+#define REPLAY_ANGLE_TOLERANCE 10 //0.1 degree
+
+struct ReplayFrame
+{
+	unsigned long time;
+	unsigned int distance;
+	int angle;
+};
+
+static std::vector<uint16_t> randomFrame;
+static uint64_t randomSlot = ~0ULL;
+static std::mt19937 sceneRandom(1234);
+
+static uint16_t randomScene(uint8_t sensor, uint64_t us)
+{
+	uint64_t slot = us / 25000;
+	if (slot != randomSlot)
+	{
+		randomSlot = slot;
+		std::fill(randomFrame.begin(), randomFrame.end(), SIMULATED_NO_RETURN);
+		uint8_t blobs = sceneRandom() % 3;
+		for (uint8_t blob = 0; blob < blobs; blob++)
+		{
+			size_t start = sceneRandom() % randomFrame.size();
+			size_t width = 1 + sceneRandom() % 4;
+			uint16_t distance = 100 + sceneRandom() % 850;
+			for (size_t index = start; (index < start + width) && (index < randomFrame.size()); index++)
+			{
+				randomFrame[index] = distance + (sceneRandom() % 120) - 60;
+			}
+		}
+	}
+	return randomFrame[sensor];
+}
+
+//Trees from before the 0.1 degree output print degree x 10.
+template <class Radar> static auto frameAngle(Radar &radar, int) -> decltype(radar.getAngleDecidegree())
+{
+	return radar.getAngleDecidegree();
+}
+
+template <class Radar> static int16_t frameAngle(Radar &radar, long)
+{
+	return radar.getAngleDegree() * 10;
+}
+
+static bool readLog(const char *path, std::vector<ReplayFrame> &frames)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return false;
+	char line[128];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		ReplayFrame frame;
+		if ((line[0] == '#') || (sscanf(line, "%lu %u %d", &frame.time, &frame.distance, &frame.angle) != 3)) continue;
+		frames.push_back(frame);
+	}
+	fclose(file);
+	return true;
+}
+
+static bool compareLog(const char *referencePath, const std::vector<ReplayFrame> &frames)
+{
+	std::vector<ReplayFrame> reference;
+	if (readLog(referencePath, reference) == false)
+	{
+		fprintf(stderr, "replay: cannot read %s\n", referencePath);
+		return false;
+	}
+	uint32_t differences = 0;
+	int largestAngleDifference = 0;
+	for (size_t index = 0; (index < frames.size()) && (index < reference.size()); index++)
+	{
+		const ReplayFrame &frame = frames[index];
+		const ReplayFrame &expected = reference[index];
+		int angleDifference = abs(frame.angle - expected.angle);
+		if (angleDifference > largestAngleDifference) largestAngleDifference = angleDifference;
+		if ((frame.time == expected.time) && (frame.distance == expected.distance) && (angleDifference <= REPLAY_ANGLE_TOLERANCE)) continue;
+		if (differences < 10)
+		{
+			fprintf(stderr, "  frame %zu: %lu %u %d, expected %lu %u %d\n", index, frame.time, frame.distance, frame.angle,
+				expected.time, expected.distance, expected.angle);
+		}
+		differences++;
+	}
+	printf("  %zu frames, %zu in %s, %u differ, largest angle difference %.1f deg\n", frames.size(), reference.size(),
+		referencePath, differences, largestAngleDifference / 10.0);
+	return (differences == 0) && (frames.size() == reference.size());
+}
+
+int main(int argc, char **argv)
+{
+	const char *scenePath = (argc > 1) ? argv[1] : "random";
+	uint8_t numberOfSensors = (argc > 2) ? atoi(argv[2]) : 9;
+	float separation = (argc > 3) ? atof(argv[3]) : 10;
+	uint32_t duration = (argc > 4) ? atol(argv[4]) : 20000;
+	const char *referencePath = (argc > 5) ? argv[5] : NULL;
+
+	createSensorChain(numberOfSensors);
+	if (strcmp(scenePath, "random") == 0)
+	{
+		randomFrame.assign(numberOfSensors, SIMULATED_NO_RETURN);
+		setScene(randomScene);
+	}
+	else if (loadScene(scenePath) == false)
+	{
+		fprintf(stderr, "replay: cannot read %s\n", scenePath);
+		return 1;
+	}
+
+	FuzzyRadar radar(numberOfSensors);
+	radar.begin(SIMULATED_XSHUT_PIN, separation);
+	std::vector<ReplayFrame> frames;
+	runRadar(radar, duration, [&]()
+	{
+		ReplayFrame frame = { millis(), radar.getDistanceMM(), frameAngle(radar, 0) };
+		frames.push_back(frame);
+	});
+	if (referencePath != NULL) return compareLog(referencePath, frames) ? 0 : 1;
+
+	for (size_t index = 0; index < frames.size(); index++)
+	{
+		printf("%lu %u %d\n", frames[index].time, frames[index].distance, frames[index].angle);
+	}
+	printf("# %zu frames\n", frames.size());
+	return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ Sweep time and bus traffic for larger arrays: several buses, a TCA9548A multiplexer and the
+ adaptive region of interest. In timed read mode the whole sweep runs inside one update() call,
+ so the worst update() time is the sweep time.
+ Exits with 1 if an update() in non-blocking read mode takes longer than one 12-byte transaction,
+ whatever the number of buses.
+*/
+
+#include "Fuzzy_Radar.h"
+#include "Radar_Simulator.h"
+#include <algorithm>
+
+struct SweepResult
+{
+	uint32_t frames;
+	uint64_t worstUpdate;	//us
+	uint64_t bytes;			//all buses
+	double angleError;		//mean, degree
+	uint32_t emptyFrames;
+	uint32_t missingInWindow;	//samples reported missing inside the scanned range
+};
+
+static uint16_t blockScene(uint8_t sensor, uint64_t us)
+{
+	return ((sensor >= 6) && (sensor <= 9)) ? 500 + 10 * sensor : SIMULATED_NO_RETURN;
+}
+
+//Centre of a 3-sensor target sweeping across sensors 2..13 every 4 s, in sensor units.
+static double sweepCentre(uint64_t us)
+{
+	double phase = fmod(us / 1e6, 4.0);
+	return (phase < 2) ? 2 + phase * 5.5 : 13 - (phase - 2) * 5.5;
+}
+
+static uint16_t sweepScene(uint8_t sensor, uint64_t us)
+{
+	if (fmod(us / 1e6, 1.5) < 0.045) return SIMULATED_NO_RETURN; //short dropout
+	double offset = fabs(sensor - sweepCentre(us));
+	return (offset <= 1.2) ? (uint16_t)(500 + 150 * offset) : SIMULATED_NO_RETURN;
+}
+
+static void countMissing(RadarFrameBuffer *frames, SweepResult &result)
+{
+	//The sensors outside the region of interest are missing at both ends, any other missing sample was not read in time.
+	while (const RadarFrame *frame = frames->peek())
+	{
+		int16_t first = -1, last = -1;
+		for (uint8_t index = 0; index < frames->getNumberOfSensors(); index++)
+		{
+			if (frame->sampleStatus[index] == SAMPLE_STATUS_MISSING) continue;
+			if (first < 0) first = index;
+			last = index;
+		}
+		for (int16_t index = first + 1; index < last; index++)
+		{
+			if (frame->sampleStatus[index] == SAMPLE_STATUS_MISSING) result.missingInWindow++;
+		}
+		frames->pop();
+	}
+}
+
+static SweepResult sweep(FuzzyRadar &radar, uint32_t durationMS, uint8_t numberOfSensors, RadarFrameBuffer *frames = NULL)
+{
+	SweepResult result = { 0, 0, 0, 0, 0, 0 };
+	uint64_t startBytes = Wire.bytes + Wire1.bytes;
+	uint32_t errorFrames = 0;
+	uint64_t end = simulatedMicros + (uint64_t)durationMS * 1000;
+	while (simulatedMicros < end)
+	{
+		simulatedMicros += 100;
+		uint64_t updateStart = simulatedMicros;
+		radar.update();
+		if (simulatedMicros - updateStart > result.worstUpdate) result.worstUpdate = simulatedMicros - updateStart;
+		if (radar.available() == false) continue;
+		if (frames != NULL) countMissing(frames, result);
+		result.frames++;
+		if (radar.getDistanceMM() == 0) result.emptyFrames++;
+		else if (millis() > 500)
+		{
+			double truth = -(sweepCentre(simulatedMicros) - (numberOfSensors - 1) / 2.0) * 10;
+			result.angleError += fabs(radar.getAngleDecidegree() / 10.0 - truth);
+			errorFrames++;
+		}
+		radar.clearAvailableFlag();
+	}
+	result.bytes = Wire.bytes + Wire1.bytes - startBytes;
+	if (errorFrames) result.angleError /= errorFrames;
+	return result;
+}
+
+static uint64_t runBuses(bool split, bool nonBlocking)
+{
+	resetSimulator();
+	createSensorChain(split ? 8 : 16, &Wire);
+	if (split) createSensorChain(8, &Wire1);
+	setScene(blockScene);
+	FuzzyRadar radar(16);
+	TwoWire *buses[] = { &Wire, &Wire1 };
+	if (split) radar.setBuses(buses, 2);
+	if (nonBlocking) radar.setReadMode(FuzzyRadar::READ_MODE_NON_BLOCKING);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	uint64_t startBytes[] = { Wire.bytes, Wire1.bytes };
+	SweepResult result = sweep(radar, 2000, 16);
+	printf("  16 sensors, %-17s %-12s %3u frames  worst update() %4llu us  bytes Wire/Wire1 %llu/%llu  d=%u a=%d\n",
+		split ? "8/8 on Wire/Wire1" : "one bus", nonBlocking ? "non-blocking" : "timed", result.frames,
+		(unsigned long long)result.worstUpdate, (unsigned long long)(Wire.bytes - startBytes[0]),
+		(unsigned long long)(Wire1.bytes - startBytes[1]), radar.getDistanceMM(), radar.getAngleDecidegree());
+	return result.worstUpdate;
+}
+
+static void runMultiplexer(uint8_t numberOfSensors, uint8_t sensorsPerChannel)
+{
+	resetSimulator();
+	createSensorChain(numberOfSensors);
+	if (sensorsPerChannel) createMultiplexer(0x70, sensorsPerChannel);
+	setScene(blockScene);
+	FuzzyRadar radar(numberOfSensors);
+	if (sensorsPerChannel && (radar.setMultiplexer(0x70, sensorsPerChannel) == false))
+	{
+		printf("  %3u sensors: setMultiplexer() refused %u sensors per channel\n", numberOfSensors, sensorsPerChannel);
+		return;
+	}
+	if (radar.begin(SIMULATED_XSHUT_PIN, 10) == false)
+	{
+		printf("  %3u sensors, %-18s begin() refused: more than %u sensors on one bus and channel\n", numberOfSensors,
+			sensorsPerChannel ? "multiplexer" : "direct", SENSOR_ADDRESS_COUNT);
+		return;
+	}
+	SweepResult result = sweep(radar, 2000, numberOfSensors);
+	uint8_t lowest = 0xFF, highest = 0;
+	for (size_t index = 0; index < simulatedSensors.size(); index++)
+	{
+		if (simulatedSensors[index]->address < lowest) lowest = simulatedSensors[index]->address;
+		if (simulatedSensors[index]->address > highest) highest = simulatedSensors[index]->address;
+	}
+	printf("  %3u sensors, %-18s sweep %5.2f ms  %6.1f bytes/frame  addresses 0x%02X..0x%02X  d=%u\n", numberOfSensors,
+		sensorsPerChannel ? "multiplexer" : "direct", result.worstUpdate / 1000.0,
+		(double)result.bytes / (result.frames ? result.frames : 1), lowest, highest, radar.getDistanceMM());
+	if (sensorsPerChannel) printf("  %3u sensors, %u per channel, %u channel selects\n", numberOfSensors, sensorsPerChannel, simulatedMultiplexers[0]->selects);
+}
+
+static void runRegionOfInterest(bool adaptive, uint8_t phases)
+{
+	resetSimulator();
+	createSensorChain(16);
+	setScene(sweepScene);
+	FuzzyRadar radar(16);
+	StaticRadarFrameBuffer<16, 4> frames;
+	radar.setFrameBuffer(&frames);
+	radar.setAdaptiveRegionOfInterest(adaptive);
+	if (phases > 1) radar.setRangingPhases(phases);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	SweepResult result = sweep(radar, 10000, 16, &frames);
+	uint32_t oldestSample = 0;
+	for (size_t index = 0; index < simulatedSensors.size(); index++) oldestSample = std::max(oldestSample, simulatedSensors[index]->oldestSampleCleared);
+	printf("  %-9s %-10s %3u frames  %2u empty  mean angle error %.2f deg  %5.1f bytes/frame  %u missing in the window, oldest sample read %u ms\n",
+		adaptive ? "adaptive" : "full scan", (phases > 1) ? "staggered" : "timed", result.frames, result.emptyFrames, result.angleError,
+		(double)result.bytes / result.frames, result.missingInWindow, oldestSample / 1000);
+}
+
+int main()
+{
+	printf("buses\n");
+	runBuses(false, false);
+	runBuses(true, false);
+	bool bounded = true;
+	for (uint8_t split = 0; split < 2; split++)
+	{
+		if (runBuses(split, true) > SIMULATED_TRANSACTION_TIME(12))
+		{
+			printf("FAIL: non-blocking update() took longer than one 12-byte transaction (%u us)\n", SIMULATED_TRANSACTION_TIME(12));
+			bounded = false;
+		}
+	}
+
+	printf("multiplexer\n");
+	static const uint8_t sizes[] = { 16, 32, 64 };
+	for (uint8_t size = 0; size < 3; size++)
+	{
+		runMultiplexer(sizes[size], 0);
+		runMultiplexer(sizes[size], 8);
+	}
+	runMultiplexer(120, 0);
+	runMultiplexer(120, 60);
+
+	printf("region of interest, 16 sensors, 3-sensor target sweeping at 55 deg/s\n");
+	runRegionOfInterest(false, 1);
+	runRegionOfInterest(true, 1);
+	runRegionOfInterest(false, 3);
+	runRegionOfInterest(true, 3);
+	return bounded ? 0 : 1;
+}
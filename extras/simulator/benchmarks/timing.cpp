@@ -0,0 +1,135 @@
+/*
+ Read modes, startup and ranging profiles on the simulated 400 kHz bus.
+ Usage: timing [numberOfSensors]
+ Exits with 1 if an update() in non-blocking read mode takes longer than the largest single
+ transaction, the 12-byte result block read.
+*/
+
+#include "Fuzzy_Radar.h"
+#include "Radar_Simulator.h"
+
+static uint8_t numberOfSensors = 9;
+
+static uint16_t blockScene(uint8_t sensor, uint64_t us)
+{
+	return ((sensor >= 3) && (sensor <= 5)) ? 500 + 10 * sensor : SIMULATED_NO_RETURN;
+}
+
+enum Setup { SETUP_TIMED, SETUP_DATA_READY, SETUP_NON_BLOCKING, SETUP_FULL_FRAME, SETUP_NON_BLOCKING_FULL_FRAME, SETUP_STAGGERED, SETUP_STAGGERED_TARGET };
+static const char *setupNames[] = { "timed", "data-ready", "non-blocking", "timed, full frame", "non-blocking, full", "staggered, 3 phases", "staggered, 24 ms" };
+
+//Longest update() allowed in non-blocking read mode, us.
+static const uint64_t nonBlockingBound = SIMULATED_TRANSACTION_TIME(12);
+
+static uint64_t runReadMode(Setup setup)
+{
+	resetSimulator();
+	createSensorChain(numberOfSensors);
+	setScene(blockScene);
+	FuzzyRadar radar(numberOfSensors);
+	if (setup == SETUP_DATA_READY) radar.setReadMode(FuzzyRadar::READ_MODE_DATA_READY);
+	if ((setup == SETUP_NON_BLOCKING) || (setup == SETUP_NON_BLOCKING_FULL_FRAME)) radar.setReadMode(FuzzyRadar::READ_MODE_NON_BLOCKING);
+	if ((setup == SETUP_FULL_FRAME) || (setup == SETUP_NON_BLOCKING_FULL_FRAME)) radar.setFullFrameRead(true);
+	if (setup == SETUP_STAGGERED) radar.setRangingPhases(3);
+	if (setup == SETUP_STAGGERED_TARGET) radar.setRangingPhases(3, 24);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+
+	uint64_t startBytes = Wire.bytes;
+	uint64_t worstUpdate = 0;
+	uint32_t frames = 0;
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	radar.resetStatistics();
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+	for (uint32_t step = 0; step < 20000; step++)
+	{
+		simulatedMicros += 100;
+		uint64_t updateStart = simulatedMicros;
+		radar.update();
+		if (simulatedMicros - updateStart > worstUpdate) worstUpdate = simulatedMicros - updateStart;
+		if (radar.available())
+		{
+			frames++;
+			radar.clearAvailableFlag();
+		}
+	}
+	printf("  %-20s startup %3u ms  period %2u ms  %5.1f Hz  worst update() %5llu us  %4.1f bytes/frame  d=%u a=%d\n",
+		setupNames[setup], radar.getStartupTimeMS(), radar.getFramePeriodMS(), radar.getFrameRate(),
+		(unsigned long long)worstUpdate, (double)(Wire.bytes - startBytes) / (frames ? frames : 1),
+		radar.getDistanceMM(), radar.getAngleDecidegree());
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	const RadarStatistics &statistics = radar.getStatistics();
+	printf("  %-20s latency min/avg/max %u/%u/%u us, bus %u us avg, %u bus errors, %u timeouts\n", "",
+		statistics.frameLatency.minimum, statistics.frameLatency.average(), statistics.frameLatency.maximum,
+		statistics.busTime.average(), statistics.busErrors, statistics.timeouts);
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+	return worstUpdate;
+}
+
+static void runStartup(uint8_t sensors)
+{
+	//Cold start, then a warm start from the calibration blobs of the cold one.
+	static uint8_t calibrationData[64 * VL53L0X::CalibrationDataSize];
+	uint16_t startup[2];
+	for (uint8_t warm = 0; warm < 2; warm++)
+	{
+		resetSimulator();
+		createSensorChain(sensors);
+		FuzzyRadar radar(sensors);
+		if (warm) radar.setCalibrationData(calibrationData);
+		radar.begin(SIMULATED_XSHUT_PIN, 10);
+		startup[warm] = radar.getStartupTimeMS();
+		for (uint8_t index = 0; index < sensors; index++)
+		{
+			radar.getCalibrationData(index, &calibrationData[index * VL53L0X::CalibrationDataSize]);
+		}
+	}
+	printf("  %2u sensors: cold %u ms, warm %u ms\n", sensors, startup[0], startup[1]);
+}
+
+static void runProfile(FuzzyRadar::RangingProfile profile, uint32_t rangingTime, bool dataReady)
+{
+	static const char *profileNames[] = { "DEFAULT", "HIGH_SPEED", "LONG_RANGE", "HIGH_ACCURACY" };
+	resetSimulator();
+	createSensorChain(numberOfSensors);
+	setScene(blockScene);
+	for (size_t index = 0; index < simulatedSensors.size(); index++) simulatedSensors[index]->rangingTime = rangingTime;
+	FuzzyRadar radar(numberOfSensors);
+	radar.setRangingProfile(profile);
+	if (dataReady) radar.setReadMode(FuzzyRadar::READ_MODE_DATA_READY);
+	radar.begin(SIMULATED_XSHUT_PIN, 10);
+	uint32_t frames = 0;
+	runRadar(radar, 2000, [&]() { frames++; });
+	printf("  %-14s %-10s sample %3u ms  period %3u ms  %5.1f Hz  %3u frames in 2 s\n", profileNames[profile],
+		dataReady ? "data-ready" : "timed", rangingTime / 1000, radar.getFramePeriodMS(), radar.getFrameRate(), frames);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1) numberOfSensors = atoi(argv[1]);
+
+	printf("read modes, %u sensors\n", numberOfSensors);
+	bool bounded = true;
+	for (uint8_t setup = SETUP_TIMED; setup <= SETUP_STAGGERED_TARGET; setup++)
+	{
+		uint64_t worstUpdate = runReadMode((Setup)setup);
+		if (((setup == SETUP_NON_BLOCKING) || (setup == SETUP_NON_BLOCKING_FULL_FRAME)) && (worstUpdate > nonBlockingBound))
+		{
+			printf("FAIL: %s update() took %llu us, more than one 12-byte transaction (%llu us)\n", setupNames[setup],
+				(unsigned long long)worstUpdate, (unsigned long long)nonBlockingBound);
+			bounded = false;
+		}
+	}
+
+	printf("startup\n");
+	runStartup(9);
+	runStartup(16);
+
+	printf("ranging profiles, %u sensors\n", numberOfSensors);
+	static const uint32_t rangingTimes[] = { SIMULATED_RANGING_TIME, 20000, 33000, 200000 };
+	for (uint8_t profile = 0; profile < 4; profile++)
+	{
+		runProfile((FuzzyRadar::RangingProfile)profile, rangingTimes[profile], false);
+		runProfile((FuzzyRadar::RangingProfile)profile, rangingTimes[profile], true);
+	}
+	return bounded ? 0 : 1;
+}
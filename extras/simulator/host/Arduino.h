@@ -0,0 +1,84 @@
+/*
+ Name:		Arduino.h
+ Host stand-in for the Arduino core, used by the FuzzyRadar simulator only.
+ The clock is simulated: millis()/micros() read simulatedMicros, which delay() and the
+ simulated I2C bus advance. Serial writes to stdout.
+*/
+
+#ifndef _Simulator_Arduino_h
+#define _Simulator_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+
+#define PROGMEM
+#define F(string) (string)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+
+extern uint64_t simulatedMicros;
+
+inline unsigned long millis() { return (unsigned long)(simulatedMicros / 1000); }
+inline unsigned long micros() { return (unsigned long)simulatedMicros; }
+inline void delay(unsigned long ms) { simulatedMicros += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { simulatedMicros += us; }
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+template <class T> T constrain(T x, T low, T high)
+{
+	return (x < low) ? low : ((x > high) ? high : x);
+}
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t value) { return fwrite(&value, 1, 1, stdout); }
+	virtual size_t write(const uint8_t *buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+	size_t print(const char *value) { return fputs(value, stdout) >= 0 ? strlen(value) : 0; }
+	size_t print(char value) { return write((uint8_t)value); }
+	size_t print(unsigned char value) { return printf("%u", value); }
+	size_t print(int value) { return printf("%d", value); }
+	size_t print(unsigned int value) { return printf("%u", value); }
+	size_t print(long value) { return printf("%ld", value); }
+	size_t print(unsigned long value) { return printf("%lu", value); }
+	size_t print(double value) { return printf("%.2f", value); }
+	size_t println() { return print("\n"); }
+	template <class T> size_t println(T value) { return print(value) + println(); }
+};
+
+class Stream : public Print
+{
+};
+
+class HardwareSerial : public Stream
+{
+public:
+	void begin(unsigned long baud) { (void)baud; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ Name:		Wire.h
+ Host stand-in for the Arduino Wire library, used by the FuzzyRadar simulator only.
+ Each TwoWire instance is one simulated 400 kHz bus: a transaction costs 23 us per byte
+ (address byte included) plus 10 us of start/stop overhead on the simulated clock, and is
+ routed to the SimulatedDevice that acknowledges the address.
+*/
+
+#ifndef _Simulator_Wire_h
+#define _Simulator_Wire_h
+
+#include "Arduino.h"
+
+#define SIMULATED_BUFFER_LENGTH 64
+#define SIMULATED_BYTE_TIME 23 //us per byte at 400 kHz, 9 clocks
+#define SIMULATED_TRANSACTION_OVERHEAD 10 //us of start/stop per transaction
+//Simulated time (us) of one transaction with _length data bytes, address byte included.
+#define SIMULATED_TRANSACTION_TIME(_length) (((_length) + 1) * SIMULATED_BYTE_TIME + SIMULATED_TRANSACTION_OVERHEAD)
+
+class SimulatedDevice
+{
+public:
+	virtual ~SimulatedDevice() {}
+	virtual bool acknowledge(uint8_t address) = 0;
+	virtual void receive(const uint8_t *buffer, uint8_t length) = 0;
+	virtual uint8_t transmit(uint8_t *buffer, uint8_t length) = 0;
+};
+
+class TwoWire
+{
+public:
+	TwoWire();
+	void begin() {}
+	void setClock(uint32_t clock) { (void)clock; }
+	void beginTransmission(uint8_t _address);
+	size_t write(uint8_t value);
+	uint8_t endTransmission(bool sendStop = true);
+	uint8_t requestFrom(uint8_t _address, uint8_t quantity, uint8_t sendStop = 1);
+	int available();
+	int read();
+
+	uint64_t bytes;			//bytes on the bus, address bytes included
+	uint64_t transactions;
+
+private:
+	void charge(uint8_t length);
+	SimulatedDevice *findDevice(uint8_t _address);
+
+	uint8_t address;
+	uint8_t transmitBuffer[SIMULATED_BUFFER_LENGTH];
+	uint8_t transmitLength;
+	uint8_t receiveBuffer[SIMULATED_BUFFER_LENGTH];
+	uint8_t receiveLength;
+	uint8_t receiveIndex;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+void attachDevice(TwoWire *bus, SimulatedDevice *device);
+
+#endif
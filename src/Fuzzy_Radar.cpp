@@ -7,52 +7,224 @@
 
 #include "Fuzzy_Radar.h"
 
+//sin(0..90 degree) in Q(GEOMETRY_FRACTION_BITS), see FuzzyRadar::sine()
+static const int16_t sineTable[91] PROGMEM = {
+	0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563, 2845, 3126, 3406, 3686, 3964, 4240,
+	4516, 4790, 5063, 5334, 5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943, 8192, 8438,
+	8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311, 10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982,
+	12176, 12365, 12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044, 14189, 14330, 14466, 14598,
+	14726, 14849, 14968, 15082, 15191, 15296, 15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+	16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382, 16384
+};
+
+//atan(k / 32) for k = 0..32 in 0.1 degree units, see FuzzyRadar::atan2Decidegree()
+static const int16_t arctangentTable[33] PROGMEM = {
+	0, 18, 36, 54, 71, 89, 106, 123, 140, 157, 174, 190, 206, 221, 236, 251,
+	266, 280, 294, 307, 320, 333, 345, 357, 369, 380, 391, 402, 412, 422, 432, 441,
+	450
+};
 
 FuzzyRadar::FuzzyRadar(uint8_t _numberOfSensors)
 	:sensor(new VL53L0X[_numberOfSensors])
 	,address(new uint8_t[_numberOfSensors])
 	,distance(new int16_t[_numberOfSensors])
-	,weight(new float[_numberOfSensors])
 {
 	numberOfSensors = _numberOfSensors;
+	ownsBuffers = true;
+	rangingData = NULL;
+	binaryFrame = NULL;
+	sensorFlags = new uint8_t[numberOfSensors];
+	sampleTime = new uint16_t[numberOfSensors];
+	sensorAngle = new int16_t[numberOfSensors];
+	heldDistance = NULL;
+	initialize();
+}
+
+FuzzyRadar::FuzzyRadar(uint8_t _numberOfSensors, VL53L0X *_sensor, uint8_t *_address, int16_t *_distance,
+	uint8_t *_sensorFlags, uint16_t *_sampleTime, VL53L0X::RangingData *_rangingData, uint8_t *_binaryFrame,
+	int16_t *_sensorAngle, int16_t *_heldDistance)
+	:sensor(_sensor)
+	,address(_address)
+	,distance(_distance)
+{
+	//Buffers are provided by StaticFuzzyRadar<N> and are never freed.
+	numberOfSensors = _numberOfSensors;
+	ownsBuffers = false;
+	rangingData = _rangingData;
+	binaryFrame = _binaryFrame;
+	sensorFlags = _sensorFlags;
+	sampleTime = _sampleTime;
+	sensorAngle = _sensorAngle;
+	heldDistance = _heldDistance;
+	initialize();
+}
 
+void FuzzyRadar::initialize()
+{
+	buses[0] = &Wire;
+	numberOfBuses = 1;
+	multiplexerAddress = 0;
+	sensorsPerChannel = 0;
+	memset(selectedChannel, 0xFF, sizeof(selectedChannel));
+	fullFrameRead = false;
+	readMode = READ_MODE_TIMED;
+	memset(sensorFlags, 0, numberOfSensors);
+	freshSampleCount = 0;
+	pollIndex = 0;
+	sweepInProgress = false;
+	memset(sampleTime, 0, sizeof(uint16_t) * numberOfSensors);
+	rangingPhases = 1;
+	targetFramePeriod = 0;
+	calibrationData = NULL;
+	multiTargetTracking = false;
+	ringGeometry = false;
+	adaptiveRegionOfInterest = false;
+	sampleValidation = false;
+	fullScanCounter = 0;
+	angleEstimator = ANGLE_ESTIMATOR_CENTROID;
+	binaryOutput = NULL;
+	frameSequence = 0;
+	frameBuffer = NULL;
+	pendingFrame = NULL;
+	#ifdef TRACKING_FILTER
+	distancePosition = 0;
+	distanceVelocity = 0;
+	anglePosition = 0;
+	angleVelocity = 0;
+	trackingMissedFrames = TRACKING_MAXIMUM_MISSED_FRAMES + 1;
+	#else
+	meanDistanceRegister = 0;
+	angleRegister = 0;
+	#endif //TRACKING_FILTER
+	filteredMeanDistance = 0;
+	filteredAngle = 0;
+	filteredX = 0;
+	filteredY = 0;
+	mountingHeight = 0;
+	numberOfTargets = 0;
+	nextTargetId = 1;
+	framePeriodRegister = 0;
+	readingCounter = 0;
+	readDataTimer = 0;
+	readDuration = READ_DATA_DURATION;
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	resetStatistics();
+	#endif //FUZZY_RADAR_INSTRUMENTATION
 }
 
 FuzzyRadar::~FuzzyRadar() 
 {
-	free(address);
+	if (ownsBuffers == false) return;
+
+	delete[] sensor;
+	sensor = NULL;
+
+	delete[] address;
 	address = NULL;
 
-	free(distance);
+	delete[] distance;
 	distance = NULL;
 
-	free(weight);
-	weight = NULL;
+	delete[] rangingData;
+	rangingData = NULL;
+
+	delete[] sensorFlags;
+	sensorFlags = NULL;
+
+	delete[] sampleTime;
+	sampleTime = NULL;
+
+	delete[] binaryFrame;
+	binaryFrame = NULL;
+
+	delete[] sensorAngle;
+	sensorAngle = NULL;
+
+	delete[] heldDistance;
+	heldDistance = NULL;
+}
+
+bool FuzzyRadar::begin(uint8_t _xshutnPin, float _seperationDegrees)
+{
+	/*
+	Evenly spaced sensors, the angle goes down with the index. See setRingGeometry() for a full ring.
+	Returns false, without starting any sensor, if more than SENSOR_ADDRESS_COUNT sensors share a bus and
+	multiplexer channel: they cannot all get their own I2C address. See setBuses() and setMultiplexer().
+	*/
+	float seperation = _seperationDegrees;
+	float startSensorOffset = -seperation * ((float)(numberOfSensors-1))/2; //set the center of the array as 0 degree
+	if (ringGeometry == true)
+	{
+		//evenly spaced over the full turn, sensor 0 at 0 degree
+		seperation = 360.0 / numberOfSensors;
+		startSensorOffset = 0;
+	}
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		setSensorAngle(index, -(index * seperation + startSensorOffset));
+	}
+
+	xshutnPin = _xshutnPin;
+	return startSensors();
 }
 
-void FuzzyRadar::begin(uint8_t _xshutnPin, float _seperationDegrees)
+bool FuzzyRadar::begin(uint8_t _xshutnPin, const float *_azimuthDegrees)
 {
+	/*
+	Sensors at any angle: _azimuthDegrees holds the azimuth of each sensor, in index order, in the frame
+	the angles are reported in. The spacing does not have to be even, but the azimuth should change
+	monotonically with the index, because groups of readings are formed between neighbouring indices.
+	Returns false as the other begin().
+	*/
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		setSensorAngle(index, _azimuthDegrees[index]);
+	}
+
 	xshutnPin = _xshutnPin;
-	seperation = _seperationDegrees;
+	return startSensors();
+}
+
+void FuzzyRadar::setSensorAngle(uint8_t index, float angleDegrees)
+{
+	//The angles of a frame are interpolated from this table.
+	int32_t angleDecidegrees = (int32_t)(angleDegrees * 10 + (angleDegrees >= 0 ? 0.5 : -0.5));
+	sensorAngle[index] = wrapAngle(angleDecidegrees);
+}
+
+int16_t FuzzyRadar::getSensorAngleDecidegree(uint8_t index)
+{
+	//Angle of sensor[index] as set by begin(), in 0.1 degree units, in the frame of getAngleDecidegree().
+	return sensorAngle[index];
+}
+
+bool FuzzyRadar::startSensors()
+{
+	uint32_t startupTimer = millis();
 	startingSensorIndex = 0;
 	endingSensorIndex = numberOfSensors-1;
 	maximumRange = DEFAULT_MAXIMUM_RANGE;
 
-	Wire.begin();
-
-	
 	//Initialize the I2C address array.
-	uint8_t addressOffset = 0; //Avoid using default address 0x52 as new address.
 	for (uint8_t index = 0; index < numberOfSensors; index++)
 	{
-		if ((STARTING_ADDRESS + index) == 0x52) addressOffset = 1;
-		address[index] = STARTING_ADDRESS + index + addressOffset;
-		if (address[index] > 127)
+		address[index] = planAddress(index);
+		if (address[index] == 0)
 		{
-			address[index] -= 127;
+			#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
+			Serial.print(F("No I2C address left for chip "));
+			Serial.println(index);
+			#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
+			return false;
 		}
 	}
 
+	for (uint8_t lane = 0; lane < numberOfBuses; lane++)
+	{
+		buses[lane]->begin();
+		selectedChannel[lane] = 0xFF;
+	}
+
 
 
 	/* Chip shutdown in now controlled by XSHUTN, using a NMOS inverter.
@@ -91,9 +263,11 @@ void FuzzyRadar::begin(uint8_t _xshutnPin, float _seperationDegrees)
 		else
 		{
 			//Subsequent chips, index = 1,2,3,4...
+			selectChannel(index - 1);
 			sensor[index - 1].setGPIO(LOW); //Enable chips other than the first chip
 		}
 		delay(5);//Required for VL53L0X firmware booting (1.2ms max).
+		selectChannel(index);
 
 		#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
 		Serial.print(F("  - Reset I2C address to "));
@@ -106,33 +280,174 @@ void FuzzyRadar::begin(uint8_t _xshutnPin, float _seperationDegrees)
 		Serial.println(F("  - Initialize the sensor."));
 		#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
 
-		sensor[index].init();
+		//Warm start from a saved calibration snapshot when one is available and valid for this chip.
+		if ((calibrationData != NULL) && (sensor[index].initFromCalibrationData(calibrationData + (uint16_t)index * VL53L0X::CalibrationDataSize) == true))
+		{
+			sensorFlags[index] |= SENSOR_FLAG_RESTORED;
+
+			#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
+			Serial.println(F("  - Restored from calibration data."));
+			#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
+		}
+		else
+		{
+			//Reference calibration is left for later, so it can run on all sensors at once.
+			sensorFlags[index] &= ~SENSOR_FLAG_RESTORED;
+			sensor[index].initWithoutCalibration();
+		}
 		sensor[index].setTimeout(500);
 
 		//delay(1000);
 	}
 
+	/*
+	Reference calibration (VHV, then phase) is a short measurement on each chip.
+	Every sensor is addressed by now, so start each calibration step on all sensors
+	and wait for them together, instead of waiting for each sensor in turn.
+	*/
+	calibrateSensors(VL53L0X::RefCalibrationVhv);
+	calibrateSensors(VL53L0X::RefCalibrationPhase);
+
+	/*
+	Ranging profiles:
+	The frame period follows the slowest sensor. With every sensor on RANGING_PROFILE_DEFAULT,
+	the array keeps the original READ_DATA_DURATION timing.
+	*/
+	uint32_t slowestTimingBudget = 0; //0 while every sensor uses the default profile
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		selectChannel(index);
+		uint32_t timingBudget = applyRangingProfile(index);
+		if (timingBudget > slowestTimingBudget) slowestTimingBudget = timingBudget;
+	}
+	readDuration = READ_DATA_DURATION;
+	if (slowestTimingBudget > 0)
+	{
+		readDuration = (slowestTimingBudget + 999) / 1000 + PROFILE_READ_MARGIN;
+	}
+
 	#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
 	Serial.println(F("Radar array configuration completed."));
 	#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
 
 
 
-	//Start continuous reading mode.
-	for (uint8_t index = 0; index < numberOfSensors; index++)
+	if (rangingPhases > 1)
 	{
+		/*
+		Staggered ranging: sensors are fired in single-shot mode, one phase group at a time
+		(index % rangingPhases), so adjacent emitters never range simultaneously.
+		A frame is published after every phase, so the timing budget is set for a phase to last the target frame period.
+		*/
+		uint32_t timingBudget = (slowestTimingBudget > 0) ? slowestTimingBudget : 33000; //VL53L0X default
+		if (targetFramePeriod > 0)
+		{
+			timingBudget = (targetFramePeriod > STAGGER_MARGIN) ? (uint32_t)(targetFramePeriod - STAGGER_MARGIN) * 1000 : 0;
+			//VL53L0X minimum, the frame period will be longer than requested.
+			if (timingBudget < STAGGER_MINIMUM_TIMING_BUDGET) timingBudget = STAGGER_MINIMUM_TIMING_BUDGET;
+		}
+		for (uint8_t index = 0; index < numberOfSensors; index++)
+		{
+			selectChannel(index);
+			sensor[index].setMeasurementTimingBudget(timingBudget);
+		}
+		phaseDuration = timingBudget / 1000 + STAGGER_MARGIN;
+
 		#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
-		Serial.print(F("Start continuous ranging mode for chip "));
-		Serial.println(index);
+		Serial.print(F("Staggered ranging, phases = "));
+		Serial.print(rangingPhases);
+		Serial.print(F(", phase duration (ms) = "));
+		Serial.println(phaseDuration);
 		#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
 
-		sensor[index].startContinuous(20);
+		currentPhase = 0;
+		startPhase(currentPhase);
 	}
+	else
+	{
+		//Start continuous reading mode.
+		for (uint8_t index = 0; index < numberOfSensors; index++)
+		{
+			#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
+			Serial.print(F("Start continuous ranging mode for chip "));
+			Serial.println(index);
+			#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
 
-	//set the center of the array as 0 degree
-	startSensorOffset = -seperation * ((float)(numberOfSensors-1))/2;
+			selectChannel(index);
+			if (slowestTimingBudget > 0)
+			{
+				//back-to-back ranging, the sample period is the timing budget of each sensor
+				sensor[index].startContinuous(0);
+			}
+			else
+			{
+				sensor[index].startContinuous(20);
+			}
+		}
+	}
 
+	//The first frame is a full frame period away, so it does not seed the frame period with a short one.
+	readDataTimer = millis();
+	frameTimer = readDataTimer;
 	hasNewData = false;
+
+	startupTime = millis() - startupTimer;
+
+	#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
+	Serial.print(F("Startup time (ms) = "));
+	Serial.println(startupTime);
+	#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
+
+	return true;
+}
+
+void FuzzyRadar::calibrateSensors(VL53L0X::refCalibrationType type)
+{
+	//Sensors restored from calibration data already have their VHV and phase settings.
+	uint8_t pendingSensors = 0;
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		if (sensorFlags[index] & SENSOR_FLAG_RESTORED)
+		{
+			sensorFlags[index] |= SENSOR_FLAG_CALIBRATED;
+			continue;
+		}
+		selectChannel(index);
+		sensor[index].startRefCalibration(type);
+		sensorFlags[index] &= ~SENSOR_FLAG_CALIBRATED;
+		pendingSensors++;
+	}
+
+	uint32_t calibrationTimer = millis();
+	while ((pendingSensors > 0) && (millis() - calibrationTimer < CALIBRATION_TIMEOUT))
+	{
+		for (uint8_t index = 0; index < numberOfSensors; index++)
+		{
+			if (sensorFlags[index] & SENSOR_FLAG_CALIBRATED) continue;
+			selectChannel(index);
+			if (sensor[index].refCalibrationDone() == false) continue;
+
+			sensorFlags[index] |= SENSOR_FLAG_CALIBRATED;
+			pendingSensors--;
+		}
+	}
+
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		if (sensorFlags[index] & SENSOR_FLAG_RESTORED) continue;
+
+		#ifdef DEBUG_PRINT_INITILAZATION_PROGRESS
+		if ((sensorFlags[index] & SENSOR_FLAG_CALIBRATED) == 0)
+		{
+			Serial.print(F("Reference calibration timeout on chip "));
+			Serial.println(index);
+		}
+		#endif //DEBUG_PRINT_INITILAZATION_PROGRESS
+
+		selectChannel(index);
+		sensor[index].finishRefCalibration();
+		sensorFlags[index] &= ~SENSOR_FLAG_CALIBRATED;
+	}
 }
 
 void FuzzyRadar::update()
@@ -142,6 +457,13 @@ void FuzzyRadar::update()
 
 int16_t FuzzyRadar::getAngleDegree()
 {
+	hasNewData = false;
+	return decidegreesToDegrees(filteredAngle);
+}
+
+int16_t FuzzyRadar::getAngleDecidegree()
+{
+	//Angle in 0.1 degree units.
 	hasNewData = false;
 	return filteredAngle;
 }
@@ -152,225 +474,615 @@ uint16_t FuzzyRadar::getDistanceMM()
 	return filteredMeanDistance;
 }
 
+int16_t FuzzyRadar::getXMM()
+{
+	/*
+	Position of the target, from getDistanceMM() and getAngleDecidegree(): x along the 0 degree direction,
+	y towards positive angles (the side of sensor 0 in a linear array). See setMountingHeightMM().
+	*/
+	hasNewData = false;
+	return filteredX;
+}
+
+int16_t FuzzyRadar::getYMM()
+{
+	hasNewData = false;
+	return filteredY;
+}
+
+void FuzzyRadar::setMountingHeightMM(uint16_t _mountingHeight)
+{
+	/*
+	For an array tilted down at the floor from _mountingHeight (mm): the distance is then the slant range,
+	and getXMM(), getYMM() and the x/y of the targets are projected on the floor plane.
+	A reading shorter than the mounting height is placed right below the array. Pass 0 to turn it off.
+	*/
+	mountingHeight = _mountingHeight;
+}
+
 void FuzzyRadar::readData()
 {
-	if (millis() - readDataTimer < READ_DATA_DURATION) return;
+	if (rangingPhases > 1)
+	{
+		readDataStaggered();
+		return;
+	}
+	if (readMode == READ_MODE_DATA_READY)
+	{
+		readDataWhenReady();
+		return;
+	}
+	if (readMode == READ_MODE_NON_BLOCKING)
+	{
+		readDataNonBlocking();
+		return;
+	}
+
+	if (millis() - readDataTimer < readDuration) return;
 	readDataTimer = millis();
 
 
 	for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
 	{
-		distance[index] = sensor[index].readReg16Bit(sensor[index].RESULT_RANGE_STATUS + 10);
-		if (distance[index] > maximumRange) distance[index] = 0;
+		readSensor(index);
 	}
 
 
 	calculateData();
 }
 
-void FuzzyRadar::calculateData()
+void FuzzyRadar::readDataWhenReady()
 {
-	resetDataValues();
-	calculateMeanDistance();
+	/*
+	Data-ready read mode:
+	Only sensors reporting a new sample in RESULT_INTERRUPT_STATUS are read, and their interrupt is cleared
+	so the next sample can be detected. The frame is published as soon as every sensor has delivered,
+	or after DATA_READY_TIMEOUT with the missing sensors reported as no reading, never as a repeated sample.
+	A sensor is not polled until DATA_READY_POLL_MARGIN before its next sample is due, one frame period after
+	its last read, and each update() polls one sensor at most, taking turns, so the bus is not kept busy
+	with polls and update() never blocks for more than one poll and read.
+	*/
+	uint8_t scanLength = endingSensorIndex - startingSensorIndex + 1;
+	for (uint8_t position = 0; position < scanLength; position++)
+	{
+		if ((pollIndex < startingSensorIndex) || (pollIndex > endingSensorIndex)) pollIndex = startingSensorIndex;
+		uint8_t index = pollIndex;
+		pollIndex++;
+		if (sensorFlags[index] & SENSOR_FLAG_FRESH_SAMPLE) continue;
+		if (getSampleAgeMS(index) + DATA_READY_POLL_MARGIN < readDuration) continue;
+
+		selectChannel(index);
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		uint32_t pollStartTime = micros();
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+		uint8_t interruptStatus = sensor[index].readReg(VL53L0X::RESULT_INTERRUPT_STATUS);
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		recordBusTransfer(index, 2, pollStartTime);
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+		if ((interruptStatus & 0x07) != 0)
+		{
+			readSensor(index);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			uint32_t clearStartTime = micros();
+			#endif //FUZZY_RADAR_INSTRUMENTATION
+			sensor[index].writeReg(VL53L0X::SYSTEM_INTERRUPT_CLEAR, 0x01);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			recordBusTransfer(index, 2, clearStartTime);
+			#endif //FUZZY_RADAR_INSTRUMENTATION
+			sensorFlags[index] |= SENSOR_FLAG_FRESH_SAMPLE;
+			freshSampleCount++;
+		}
+		break;
+	}
 
-	#ifdef DEBUG_PRINT_RAW_DATA_BEFORE_FILTER
-	printRawData();
-	#endif //DEBUG_PRINT_RAW_DATA_BEFORE_FILTER
+	bool frameComplete = (freshSampleCount > (endingSensorIndex - startingSensorIndex));
+	//The timeout grows with the frame period of slower ranging profiles.
+	uint16_t dataReadyTimeout = DATA_READY_TIMEOUT - READ_DATA_DURATION + readDuration;
+	if ((frameComplete == false) && (millis() - readDataTimer < dataReadyTimeout)) return;
+	readDataTimer = millis();
 
-	if (meanDistance == 0)
+	for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
 	{
-		readingCounter = 0;
+		if ((sensorFlags[index] & SENSOR_FLAG_FRESH_SAMPLE) == 0)
+		{
+			distance[index] = 0;
+			setSampleStatus(index, SAMPLE_STATUS_MISSING);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			statistics.timeouts++;
+			#endif //FUZZY_RADAR_INSTRUMENTATION
+		}
+		sensorFlags[index] &= ~SENSOR_FLAG_FRESH_SAMPLE;
 	}
+	freshSampleCount = 0;
 
-	if (meanDistance > 0)
+	calculateData();
+}
+
+void FuzzyRadar::readDataStaggered()
+{
+	/*
+	Staggered ranging:
+	Every phaseDuration, the group fired in the previous phase is read and the next group is fired.
+	A frame is published after every phase, with the samples just read and the newest sample of each
+	other group, so the frame rate is that of the phases and each sample is at most one frame old.
+	A sensor that has not finished its measurement, or whose sample is older than rangingPhases phases
+	(e.g. it just entered the region of interest), is reported as missing.
+	*/
+	if (millis() - readDataTimer < phaseDuration) return;
+	readDataTimer = millis();
+
+	for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
 	{
-		//Deviation removal: remove the data that are too far away from mean value.
-		bool recalculateMeanDistance = false;
-		for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
+		if ((index % rangingPhases) != currentPhase)
 		{
-			if ((distance[index]>0) && (abs(distance[index] - meanDistance) > DEVIATION_THRESHOLD))
+			//calculateData() below modifies distance[], so the held sample of the other groups is put back for every frame.
+			if (getSampleAgeMS(index) > (uint16_t)rangingPhases * phaseDuration)
 			{
-				distance[index] = 0;
-				recalculateMeanDistance = true;
+				heldDistance[index] = 0;
+				setSampleStatus(index, SAMPLE_STATUS_MISSING);
 			}
+			distance[index] = heldDistance[index];
+			continue;
 		}
-		if (recalculateMeanDistance == true)
-		{
 
-			resetDataValues();
-			calculateMeanDistance();
+		selectChannel(index);
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		uint32_t pollStartTime = micros();
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+		uint8_t interruptStatus = sensor[index].readReg(VL53L0X::RESULT_INTERRUPT_STATUS);
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		recordBusTransfer(index, 2, pollStartTime);
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+
+		if (interruptStatus & 0x07)
+		{
+			readSensor(index);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			uint32_t clearStartTime = micros();
+			#endif //FUZZY_RADAR_INSTRUMENTATION
+			sensor[index].writeReg(VL53L0X::SYSTEM_INTERRUPT_CLEAR, 0x01);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			recordBusTransfer(index, 2, clearStartTime);
+			#endif //FUZZY_RADAR_INSTRUMENTATION
 		}
-		//Noise removal
-		if (readingCounter < NOISE_LENGTH)
+		else
 		{
-			readingCounter++;
-			clearDataValues();
+			distance[index] = 0;
+			setSampleStatus(index, SAMPLE_STATUS_MISSING);
+			#ifdef FUZZY_RADAR_INSTRUMENTATION
+			statistics.timeouts++;
+			#endif //FUZZY_RADAR_INSTRUMENTATION
 		}
+		heldDistance[index] = distance[index];
 	}
 
-	
-	if (meanDistance > 0)
-	{
-
-		/*
-		Primary target filtering:
-		Only the group with most number of sensor readings remains.
-		If there are multiple groups with same number of readings, the closet target remains.
+	currentPhase++;
+	if (currentPhase >= rangingPhases) currentPhase = 0;
 
-		1. Scan sequentially
-		2. Note down the starting index for a group
-		3. Note down the length for end of group (zero or end of sensor)
-		4. Note down the mean of the group
-		5. Replace the starting index/length to the stored primary if the new group length is larger.
-		6. If the length is the same as stored, compare the mean. Replace if the new group is closer.
+	//The frame is calculated first: with the adaptive region of interest it moves the window, and the
+	//next group has to be fired over the window it will be read from.
+	calculateData();
+	startPhase(currentPhase);
+}
 
-		*/
+void FuzzyRadar::startPhase(uint8_t phase)
+{
+	for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
+	{
+		if ((index % rangingPhases) != phase) continue;
+
+		selectChannel(index);
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		uint32_t startTime = micros();
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+		sensor[index].startSingle();
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		recordBusTransfer(index, 16, startTime); //8 register writes
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+	}
+}
 
-		uint8_t currentGroupReadingCounter = 0;
-		uint8_t currentGroupLength = 0;
-		uint8_t currentGroupStartingIndex = 0;
-		uint16_t currentGroupTotal = 0;
-		uint16_t currentGroupMeanDistance = 0;
-		uint8_t primaryGroupLength = 0;
-		uint8_t primaryGroupStartingIndex = 0;
-		uint16_t primaryGroupMeanDistance = 0;
-		for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++) //scanning
+void FuzzyRadar::readDataNonBlocking()
+{
+	/*
+	Non-blocking read mode:
+	The sweep over all sensors is queued as one register read per sensor, and every call of update()
+	performs only the next bus operation (register pointer write or data request) of the current sensor.
+	The main loop is therefore blocked for a single short I2C transaction instead of the whole sweep.
+	When the array is split across several buses, each bus runs its own sweep over its sensors, and the
+	buses take turns: every call of update() performs the next operation on one bus only. The frame is merged in distance[].
+	available() turns true when the last sensor of the sweep has completed.
+	*/
+	if (sweepInProgress == false)
+	{
+		if (millis() - readDataTimer < readDuration) return;
+		readDataTimer = millis();
+		sweepInProgress = true;
+		for (uint8_t lane = 0; lane < numberOfBuses; lane++)
 		{
-			if (distance[index] > 0)
-			{
-				if (currentGroupReadingCounter > 0)
-				{
-					//continue a group
-					//Serial.print(" CG=");
-					//Serial.print(index);
-				}
-				else
-				{
-					//starting a new group
-					currentGroupStartingIndex = index;
-					//Serial.print(" NG=");
-					//Serial.print(index);
-
-				}
-				currentGroupReadingCounter++;
-			}
-
-			if (currentGroupReadingCounter > 0) //a group has started
-			{
-				//Serial.print(" GS=");
-				//Serial.print(index);
-				if ((distance[index] == 0) || (index == endingSensorIndex))
-				{
-					//ending a group, or end of scanning
-					//calculate length
-					if (distance[index] == 0)
-					{
-						//zero reading, no matter end of scanning or not
-						currentGroupLength = index - currentGroupStartingIndex;
-						//Serial.print(" ZR=");
-						//Serial.print(index);
-					}
-					else
-					{
-						//available reading, but end of scanning
-						currentGroupLength = index - currentGroupStartingIndex + 1;
-						//Serial.print(" ES=");
-						//Serial.print(index);
-
-					}
-					//Serial.print(" GL=");
-					//Serial.print(currentGroupLength);
-					//calculate mean
-					currentGroupTotal = 0;
-					for (uint8_t groupIndex = currentGroupStartingIndex; groupIndex <= index; groupIndex++)
-					{
-						currentGroupTotal += distance[groupIndex];
-					}
-					currentGroupMeanDistance = currentGroupTotal / currentGroupLength;
-
-					//replace primary target if required
-					if (currentGroupLength > primaryGroupLength)
-					{
-						//get the largest target
-						primaryGroupLength = currentGroupLength;
-						primaryGroupStartingIndex = currentGroupStartingIndex;
-						primaryGroupMeanDistance = currentGroupMeanDistance;
-						//Serial.print(" LT=");
-						//Serial.print(index);
-					}
-					else if (currentGroupLength == primaryGroupLength)
-					{
-						//Serial.print(" CM=");
-						//Serial.print(currentGroupMeanDistance);
-						//Serial.print(" PM=");
-						//Serial.print(primaryGroupMeanDistance);
-
-						if (currentGroupMeanDistance < primaryGroupMeanDistance)
-						{
-							//same size, get the closer target
-							primaryGroupLength = currentGroupLength;
-							primaryGroupStartingIndex = currentGroupStartingIndex;
-							primaryGroupMeanDistance = currentGroupMeanDistance;
-							//Serial.print(" CL=");
-							//Serial.print(index);
-						}
-
-					}
-
-					//reset values for next scanning
-					currentGroupReadingCounter = 0;
-					currentGroupLength = 0;
-					currentGroupStartingIndex = 0;
-					currentGroupTotal;
-					currentGroupMeanDistance = 0;
-				}
-
-			} //if (currentGroupReadingCounter > 0) //a group has started //if (currentGroupReadingCounter > 0) //a group has started
-
-
-		} //for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++) //scanning
+			laneIndex[lane] = nextSensorOnBus(lane, startingSensorIndex);
+			if (laneIndex[lane] <= endingSensorIndex) queueSensorRead(laneIndex[lane]);
+		}
+		currentLane = numberOfBuses - 1;
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		frameStarted = true;
+		frameStartTime = micros();
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+	}
 
+	//Next bus, after the one stepped last, that still has a sensor to read.
+	for (uint8_t turn = 0; turn < numberOfBuses; turn++)
+	{
+		currentLane = (currentLane + 1 < numberOfBuses) ? (currentLane + 1) : 0;
+		if (laneIndex[currentLane] <= endingSensorIndex) break;
+	}
 
-		if (primaryGroupLength != 0)
+	uint16_t index = laneIndex[currentLane];
+	if (index <= endingSensorIndex)
+	{
+		#ifdef FUZZY_RADAR_INSTRUMENTATION
+		uint32_t stepStartTime = micros();
+		bool transactionDone = sensor[index].stepTransaction();
+		frameBusTime += micros() - stepStartTime;
+		#else
+		bool transactionDone = sensor[index].stepTransaction();
+		#endif //FUZZY_RADAR_INSTRUMENTATION
+		if (transactionDone == true)
 		{
-			//remove non-primary data
-			for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
-			{
-				if ((index<primaryGroupStartingIndex) || (index>(primaryGroupStartingIndex + primaryGroupLength - 1)))
-				{
-					distance[index] = 0;
-				}
-			}
-			calculateMeanDistance();
+			completeSensorRead(index);
+			index = nextSensorOnBus(currentLane, index + 1);
+			laneIndex[currentLane] = index;
+			if (index <= endingSensorIndex) queueSensorRead(index);
 		}
+	}
 
-		//get weight for each detected sensor
-		for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
-		{
-			if (distance[index] > 0)
-			{
-				weight[index] = (float)meanDistance / (float)distance[index];
+	for (uint8_t lane = 0; lane < numberOfBuses; lane++)
+	{
+		if (laneIndex[lane] <= endingSensorIndex) return;
+	}
 
-				weightedTotal += weight[index] * index;
-			}
+	sweepInProgress = false;
+	calculateData();
+}
 
-		}
+uint16_t FuzzyRadar::nextSensorOnBus(uint8_t lane, uint16_t index)
+{
+	//First sensor from index on that is connected to buses[lane], or endingSensorIndex + 1.
+	while ((index <= endingSensorIndex) && (sensor[index].getBus() != buses[lane])) index++;
+	return index;
+}
 
-		weightedIndex = weightedTotal / numberOfReadings;
+void FuzzyRadar::queueSensorRead(uint8_t index)
+{
+	/*
+	Switching the multiplexer channel is a short blocking transaction, the channel then stays enabled until the read completes.
+	The buses share transactionBuffer: the data request fills it and completeSensorRead() decodes it in the same update().
+	*/
+	selectChannel(index);
+	if (fullFrameRead == true)
+	{
+		sensor[index].queueReadMulti(VL53L0X::RESULT_RANGE_STATUS, transactionBuffer, 12);
+	}
+	else
+	{
+		sensor[index].queueReadMulti(VL53L0X::RESULT_RANGE_STATUS + 10, transactionBuffer, 2);
+	}
+}
 
-		angle = -(weightedIndex * seperation + startSensorOffset);
+void FuzzyRadar::completeSensorRead(uint8_t index)
+{
+	sampleTime[index] = millis();
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	//The time of the transaction steps is added in readDataNonBlocking().
+	recordBusTransfer(index, (fullFrameRead == true) ? 13 : 3, micros());
+	#endif //FUZZY_RADAR_INSTRUMENTATION
 
+	if (sensor[index].last_status != 0)
+	{
+		//NACK or bus error, nothing to decode
+		distance[index] = 0;
+	}
+	else if (fullFrameRead == true)
+	{
+		VL53L0X::decodeRangingData(transactionBuffer, &rangingData[index]);
+		distance[index] = rangingData[index].range_mm;
 	}
+	else
+	{
+		distance[index] = ((uint16_t)transactionBuffer[0] << 8) | transactionBuffer[1];
+	}
+	validateSample(index);
+}
 
+void FuzzyRadar::readSensor(uint8_t index)
+{
+	selectChannel(index);
+	sampleTime[index] = millis();
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	uint32_t readStartTime = micros();
+	#endif //FUZZY_RADAR_INSTRUMENTATION
 
-	if (meanDistanceRegister == 0)
+	if (fullFrameRead == true)
 	{
-		//fill the filter with first sample value
-		meanDistanceRegister = meanDistance << MEAN_DISTANCE_FILTER_SHIFT;
-		filteredMeanDistance = meanDistance;
-
-		angleRegister = angle << ANGLE_FILTER_SHIFT;
-		filteredAngle = angle;
+		//One burst for the whole result block: status, signal/ambient rate, SPAD count and range.
+		sensor[index].readRangingData(&rangingData[index]);
+		distance[index] = rangingData[index].range_mm;
+	}
+	else
+	{
+		distance[index] = sensor[index].readReg16Bit(sensor[index].RESULT_RANGE_STATUS + 10);
+	}
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	recordBusTransfer(index, (fullFrameRead == true) ? 13 : 3, readStartTime); //register address + data
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+	validateSample(index);
+}
+
+void FuzzyRadar::validateSample(uint8_t index)
+{
+	//Classifies the sample just read into distance[], and clears it if it cannot be used.
+	uint8_t status = SAMPLE_STATUS_VALID;
+	if (sensor[index].last_status != 0)
+	{
+		//NACK or bus error, no reading from this sensor in this frame.
+		status = SAMPLE_STATUS_BUS_ERROR;
+	}
+	else if ((sampleValidation == true) && (fullFrameRead == true))
+	{
+		status = classifyRangingData(index);
+	}
+	if ((status == SAMPLE_STATUS_VALID) && ((distance[index] == 0) || (distance[index] > maximumRange)))
+	{
+		status = SAMPLE_STATUS_NO_READING;
+	}
+
+	if (status != SAMPLE_STATUS_VALID) distance[index] = 0;
+	setSampleStatus(index, status);
+}
+
+uint8_t FuzzyRadar::classifyRangingData(uint8_t index)
+{
+	//based on VL53L0X_get_pal_range_status()
+	const VL53L0X::RangingData &data = rangingData[index];
+	if (data.range_mm >= 8190) return SAMPLE_STATUS_NO_READING;
+
+	uint8_t deviceRangeStatus = (data.range_status & 0x78) >> 3;
+	switch (deviceRangeStatus)
+	{
+	case 1: case 2: case 3: //hardware fail
+	case 8: case 10: //minimum range fail
+		return SAMPLE_STATUS_DEVICE_ERROR;
+	case 4:
+		return SAMPLE_STATUS_SIGNAL_FAIL;
+	case 6: case 9:
+		return SAMPLE_STATUS_PHASE_FAIL;
+	default:
+		break;
+	}
+
+	//Without an explicit minimum, a sample is only rejected below the limit the sensor itself ranges with.
+	uint16_t signalRateLimit = minimumSignalRate;
+	if (signalRateLimit == 0)
+	{
+		if (getRangingProfile(index) == RANGING_PROFILE_LONG_RANGE) signalRateLimit = LONG_RANGE_SIGNAL_RATE_LIMIT * (1 << 7);
+		else signalRateLimit = DEFAULT_SIGNAL_RATE_LIMIT * (1 << 7);
+	}
+
+	if ((data.signal_rate < signalRateLimit) || (data.ambient_rate > maximumAmbientRate)) return SAMPLE_STATUS_LOW_CONFIDENCE;
+	return SAMPLE_STATUS_VALID;
+}
+
+uint16_t FuzzyRadar::getSampleConfidence(uint8_t index)
+{
+	//Share of the return signal in the total return rate, 0 to 256 (Q8).
+	uint32_t signalRate = rangingData[index].signal_rate;
+	uint32_t totalRate = signalRate + rangingData[index].ambient_rate;
+	if (totalRate == 0) return 0;
+	return (signalRate << 8) / totalRate;
+}
+
+void FuzzyRadar::setSampleStatus(uint8_t index, uint8_t status)
+{
+	sensorFlags[index] = (sensorFlags[index] & ~SENSOR_SAMPLE_STATUS_MASK) | (status << SENSOR_SAMPLE_STATUS_SHIFT);
+}
+
+uint8_t FuzzyRadar::getSampleStatus(uint8_t index)
+{
+	//SAMPLE_STATUS_* of the sample read for the current frame.
+	if ((index < startingSensorIndex) || (index > endingSensorIndex)) return SAMPLE_STATUS_MISSING;
+	return (sensorFlags[index] & SENSOR_SAMPLE_STATUS_MASK) >> SENSOR_SAMPLE_STATUS_SHIFT;
+}
+
+void FuzzyRadar::calculateData()
+{
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	computeStartTime = micros();
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+
+	//The samples are copied before the filters below modify distance[].
+	if (binaryOutput != NULL)
+	{
+		packBinarySamples();
+	}
+	if (frameBuffer != NULL)
+	{
+		pendingFrame = frameBuffer->claim();
+		if (pendingFrame != NULL)
+		{
+			for (uint8_t index = 0; index < numberOfSensors; index++)
+			{
+				pendingFrame->sampleDistance[index] = ((index >= startingSensorIndex) && (index <= endingSensorIndex)) ? distance[index] : 0;
+				pendingFrame->sampleStatus[index] = getSampleStatus(index);
+			}
+		}
+	}
+
+	if (multiTargetTracking == true)
+	{
+		//Before the primary target filter below removes every other group from distance[].
+		calculateTargets();
+	}
+
+	resetDataValues();
+	calculateMeanDistance();
+
+	#ifdef DEBUG_PRINT_RAW_DATA_BEFORE_FILTER
+	printRawData();
+	#endif //DEBUG_PRINT_RAW_DATA_BEFORE_FILTER
+
+	if (meanDistance == 0)
+	{
+		readingCounter = 0;
+	}
+
+	if (meanDistance > 0)
+	{
+		/*
+		Deviation removal and primary target filtering, fused into one scan:
+		Readings that are too far away from the mean value are removed, and the remaining readings are
+		grouped on the fly with a running group length and total. When a group ends (zero reading or end
+		of scanning), it replaces the stored primary group if it is longer, or if it has the same length
+		but is closer. Only the group with most number of sensor readings remains.
+		*/
+		uint8_t currentGroupLength = 0;
+		uint8_t currentGroupStartingIndex = 0;
+		uint32_t currentGroupTotal = 0;
+		uint8_t primaryGroupLength = 0;
+		uint8_t primaryGroupStartingIndex = 0;
+		uint32_t primaryGroupTotal = 0;
+		uint16_t primaryGroupMeanDistance = 0;
+		uint8_t scanStartingIndex = getScanStartingIndex();
+		uint8_t scanLength = endingSensorIndex - startingSensorIndex + 1;
+		for (uint8_t position = 0; position < scanLength; position++) //scanning
+		{
+			uint8_t index = ringIndex((uint16_t)scanStartingIndex + position);
+			if ((distance[index] > 0) && (abs(distance[index] - meanDistance) > DEVIATION_THRESHOLD))
+			{
+				distance[index] = 0;
+			}
+
+			if (distance[index] > 0)
+			{
+				if (currentGroupLength == 0)
+				{
+					//starting a new group
+					currentGroupStartingIndex = index;
+					currentGroupTotal = 0;
+				}
+				currentGroupLength++;
+				currentGroupTotal += distance[index];
+			}
+
+			if ((currentGroupLength > 0) && ((distance[index] == 0) || (position == scanLength - 1)))
+			{
+				//ending a group, or end of scanning
+				uint16_t currentGroupMeanDistance = currentGroupTotal / currentGroupLength;
+
+				//replace primary target if required: get the largest target, or the closer one for the same size
+				if ((currentGroupLength > primaryGroupLength) ||
+					((currentGroupLength == primaryGroupLength) && (currentGroupMeanDistance < primaryGroupMeanDistance)))
+				{
+					primaryGroupLength = currentGroupLength;
+					primaryGroupStartingIndex = currentGroupStartingIndex;
+					primaryGroupTotal = currentGroupTotal;
+					primaryGroupMeanDistance = currentGroupMeanDistance;
+				}
+
+				//reset values for next scanning
+				currentGroupLength = 0;
+			}
+		} //for (uint8_t position = 0; position < scanLength; position++) //scanning
+
+		//Noise removal
+		if (readingCounter < NOISE_LENGTH)
+		{
+			readingCounter++;
+			clearDataValues();
+			primaryGroupLength = 0;
+		}
+
+		if (primaryGroupLength != 0)
+		{
+			//The primary group statistics are the mean distance of the remaining readings.
+			numberOfReadings = primaryGroupLength;
+			total = primaryGroupTotal;
+			meanDistance = total / numberOfReadings;
+
+			//remove non-primary data
+			for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
+			{
+				//position in the primary group, which may wrap past the last sensor of a ring
+				uint8_t groupPosition = (index >= primaryGroupStartingIndex) ? (index - primaryGroupStartingIndex) : (index + numberOfSensors - primaryGroupStartingIndex);
+				if (groupPosition >= primaryGroupLength)
+				{
+					distance[index] = 0;
+				}
+			}
+
+			angle = calculateGroupAngle(primaryGroupStartingIndex, primaryGroupLength, meanDistance);
+		}
+		else
+		{
+			//Every reading was removed by the deviation or noise filter.
+			resetDataValues();
+		}
+	}
+
+
+	#ifdef TRACKING_FILTER
+	if (meanDistance > 0)
+	{
+		if (trackingMissedFrames > TRACKING_MAXIMUM_MISSED_FRAMES)
+		{
+			//not tracking yet, fill the filter with first sample value and zero velocity
+			distancePosition = (int32_t)meanDistance << TRACKING_FRACTION_BITS;
+			distanceVelocity = 0;
+			anglePosition = (int32_t)angle << TRACKING_FRACTION_BITS;
+			angleVelocity = 0;
+		}
+		else
+		{
+			updateTrackingFilter(distancePosition, distanceVelocity, meanDistance);
+			//In a ring, the measured angle is taken next to the tracked angle, so the filter does not jump across 0 degree.
+			int16_t trackedAngle = anglePosition >> TRACKING_FRACTION_BITS;
+			updateTrackingFilter(anglePosition, angleVelocity, trackedAngle + getAngleDifference(angle, trackedAngle));
+		}
+		trackingMissedFrames = 0;
+	}
+	else if (trackingMissedFrames < TRACKING_MAXIMUM_MISSED_FRAMES)
+	{
+		//short dropout, coast on the predicted position
+		distancePosition += distanceVelocity;
+		anglePosition += angleVelocity;
+		if (distancePosition < 0) distancePosition = 0;
+		trackingMissedFrames++;
+	}
+	else
+	{
+		//target lost, flush the filter
+		distancePosition = 0;
+		distanceVelocity = 0;
+		anglePosition = 0;
+		angleVelocity = 0;
+		trackingMissedFrames = TRACKING_MAXIMUM_MISSED_FRAMES + 1;
+	}
+	if (ringGeometry == true)
+	{
+		int32_t fullTurn = (int32_t)FULL_TURN_DECIDEGREES << TRACKING_FRACTION_BITS;
+		if (anglePosition < 0) anglePosition += fullTurn;
+		if (anglePosition >= fullTurn) anglePosition -= fullTurn;
+	}
+	filteredMeanDistance = distancePosition >> TRACKING_FRACTION_BITS;
+	filteredAngle = anglePosition >> TRACKING_FRACTION_BITS;
+	#else
+	if (meanDistanceRegister == 0)
+	{
+		//fill the filter with first sample value
+		meanDistanceRegister = meanDistance << MEAN_DISTANCE_FILTER_SHIFT;
+		filteredMeanDistance = meanDistance;
+
+		angleRegister = angle << ANGLE_FILTER_SHIFT;
+		filteredAngle = angle;
 	}
 	else
 	{
@@ -380,7 +1092,14 @@ void FuzzyRadar::calculateData()
 			meanDistanceRegister = meanDistanceRegister - (meanDistanceRegister >> MEAN_DISTANCE_FILTER_SHIFT) + meanDistance;
 			filteredMeanDistance = meanDistanceRegister >> MEAN_DISTANCE_FILTER_SHIFT;
 
-			angleRegister = angleRegister - (angleRegister >> ANGLE_FILTER_SHIFT) + angle;
+			//In a ring, the angle is taken next to the filtered angle, so the filter does not jump across 0 degree.
+			angleRegister = angleRegister - (angleRegister >> ANGLE_FILTER_SHIFT) + filteredAngle + getAngleDifference(angle, filteredAngle);
+			if (ringGeometry == true)
+			{
+				int32_t fullTurn = (int32_t)FULL_TURN_DECIDEGREES << ANGLE_FILTER_SHIFT;
+				if (angleRegister < 0) angleRegister += fullTurn;
+				if (angleRegister >= fullTurn) angleRegister -= fullTurn;
+			}
 			filteredAngle = angleRegister >> ANGLE_FILTER_SHIFT;
 		}
 		else
@@ -393,7 +1112,13 @@ void FuzzyRadar::calculateData()
 			filteredAngle = 0;
 		}
 	}
+	#endif //TRACKING_FILTER
 
+	toCartesian(filteredMeanDistance, filteredAngle, filteredX, filteredY);
+
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	computeDoneTime = micros();
+	#endif //FUZZY_RADAR_INSTRUMENTATION
 	
 	#ifdef DEBUG_PRINT_RAW_DATA_AFTER_FILTER
 	printRawData();
@@ -408,25 +1133,563 @@ void FuzzyRadar::calculateData()
 	Serial.print(filteredMeanDistance);
 	Serial.print(" ");
 	Serial.print("Angle = ");
-	if (filteredAngle >= 0)
+	int16_t filteredAngleDegree = decidegreesToDegrees(filteredAngle);
+	if (filteredAngleDegree >= 0)
 	{
 		Serial.print(" ");
-		Serial.print((filteredAngle < 10 ? "0" : ""));
-		Serial.print((filteredAngle < 100 ? "0" : ""));
-		Serial.print(filteredAngle);
+		Serial.print((filteredAngleDegree < 10 ? "0" : ""));
+		Serial.print((filteredAngleDegree < 100 ? "0" : ""));
+		Serial.print(filteredAngleDegree);
 	}
 	else
 	{
-		Serial.print("-");
-		Serial.print((filteredAngle > -10 ? "0" : ""));
-		Serial.print((filteredAngle > -100 ? "0" : ""));
-		Serial.print(abs(filteredAngle));
+		Serial.print("-");
+		Serial.print((filteredAngleDegree > -10 ? "0" : ""));
+		Serial.print((filteredAngleDegree > -100 ? "0" : ""));
+		Serial.print(abs(filteredAngleDegree));
+	}
+
+	Serial.println();
+	#endif //DEBUG_PRINT_DISTANCE_ANGLE
+
+	updateFramePeriod();
+	hasNewData = true;
+
+	if (binaryOutput != NULL)
+	{
+		writeBinaryFrame();
+	}
+	if (pendingFrame != NULL)
+	{
+		pendingFrame->timestamp = millis();
+		pendingFrame->sequence = frameSequence;
+		pendingFrame->distance = filteredMeanDistance;
+		pendingFrame->angle = filteredAngle;
+		pendingFrame->x = filteredX;
+		pendingFrame->y = filteredY;
+		pendingFrame->numberOfTargets = numberOfTargets;
+		memcpy(pendingFrame->targets, targets, sizeof(RadarTarget) * numberOfTargets);
+		frameBuffer->publish();
+		pendingFrame = NULL;
+	}
+	frameSequence++;
+
+	if (adaptiveRegionOfInterest == true)
+	{
+		updateRegionOfInterest();
+	}
+
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	uint32_t publishTime = micros();
+	if (frameStarted == false) frameStartTime = computeStartTime; //no sensor was read in this frame
+	uint32_t latency = publishTime - frameStartTime;
+	statistics.frames++;
+	recordTimer(statistics.busTime, frameBusTime);
+	recordTimer(statistics.acquisitionTime, computeStartTime - frameStartTime);
+	recordTimer(statistics.computeTime, computeDoneTime - computeStartTime);
+	recordTimer(statistics.outputTime, publishTime - computeDoneTime);
+	recordTimer(statistics.frameLatency, latency);
+	uint32_t bin = latency / STATISTICS_HISTOGRAM_BIN_WIDTH;
+	if (bin >= STATISTICS_HISTOGRAM_BINS) bin = STATISTICS_HISTOGRAM_BINS - 1;
+	statistics.latencyHistogram[bin]++;
+	frameStarted = false;
+	frameBusTime = 0;
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+}
+
+#ifdef TRACKING_FILTER
+void FuzzyRadar::updateTrackingFilter(int32_t &position, int32_t &velocity, int16_t measurement)
+{
+	/*
+	Constant-velocity alpha-beta filter, one step per frame, in Q(TRACKING_FRACTION_BITS) fixed point.
+	The position is predicted one frame ahead, then corrected by alpha = 1/2^TRACKING_ALPHA_SHIFT of the
+	residual, and the velocity by beta = 1/2^TRACKING_BETA_SHIFT of the residual.
+	*/
+	int32_t predictedPosition = position + velocity;
+	int32_t residual = ((int32_t)measurement << TRACKING_FRACTION_BITS) - predictedPosition;
+	position = predictedPosition + (residual >> TRACKING_ALPHA_SHIFT);
+	velocity += residual >> TRACKING_BETA_SHIFT;
+}
+#endif //TRACKING_FILTER
+
+int16_t FuzzyRadar::calculateGroupAngle(uint8_t groupStartingIndex, uint8_t groupLength, uint16_t groupMeanDistance)
+{
+	/*
+	Returns the angle of a group of consecutive readings, in 0.1 degree units.
+	The group is walked by position, which keeps counting past the last sensor of a ring,
+	so the estimators below see the sensors of a wrapped group in order.
+	*/
+	uint16_t groupEndingPosition = (uint16_t)groupStartingIndex + groupLength - 1;
+
+	if ((angleEstimator == ANGLE_ESTIMATOR_PARABOLIC) && (groupLength >= 3))
+	{
+		/*
+		Parabolic peak fit:
+		A parabola is fitted through the closest reading of the group and its two neighbours,
+		and the angle is taken at the vertex. Falls back to the centroid when the closest reading
+		is at the edge of the group, or the three readings are not convex.
+		*/
+		uint16_t peakPosition = groupStartingIndex;
+		for (uint16_t position = (uint16_t)groupStartingIndex + 1; position <= groupEndingPosition; position++)
+		{
+			if (distance[ringIndex(position)] < distance[ringIndex(peakPosition)]) peakPosition = position;
+		}
+
+		if ((peakPosition > groupStartingIndex) && (peakPosition < groupEndingPosition))
+		{
+			int32_t leftDistance = distance[ringIndex(peakPosition - 1)];
+			int32_t peakDistance = distance[ringIndex(peakPosition)];
+			int32_t rightDistance = distance[ringIndex(peakPosition + 1)];
+			int32_t curvature = leftDistance - 2 * peakDistance + rightDistance;
+			if (curvature > 0)
+			{
+				//vertex offset = (left - right) / (2 x curvature), at most half a sensor
+				int32_t offsetFixed = ((leftDistance - rightDistance) << (CENTROID_FRACTION_BITS - 1)) / curvature;
+				int32_t halfSensor = (int32_t)1 << (CENTROID_FRACTION_BITS - 1);
+				offsetFixed = constrain(offsetFixed, -halfSensor, halfSensor);
+				return indexToAngle(((int32_t)peakPosition << CENTROID_FRACTION_BITS) + offsetFixed);
+			}
+		}
+	}
+
+	if (((angleEstimator == ANGLE_ESTIMATOR_SIGNAL_WEIGHTED) || (angleEstimator == ANGLE_ESTIMATOR_SIGNAL_PER_SPAD)) && (fullFrameRead == true))
+	{
+		/*
+		Signal weighted centroid:
+		A sensor that only partly overlaps the target returns a weaker signal, but its range is close to
+		that of the target, so the signal rate tells better than the distance how much of the beam is on target.
+		*/
+		uint32_t signalWeightedTotal = 0;
+		uint32_t signalWeightTotal = 0;
+		for (uint16_t position = groupStartingIndex; position <= groupEndingPosition; position++)
+		{
+			uint8_t index = ringIndex(position);
+			if (distance[index] == 0) continue;
+
+			uint32_t weight = rangingData[index].signal_rate; //9.7 fixed point
+			if (angleEstimator == ANGLE_ESTIMATOR_SIGNAL_PER_SPAD)
+			{
+				if (rangingData[index].effective_spad_rtn_count == 0) continue;
+				weight = (weight << 8) / rangingData[index].effective_spad_rtn_count; //SPAD count is 8.8 fixed point
+			}
+			weight = (weight >> 4) + 1; //keeps the totals within 32 bits, and never 0
+
+			signalWeightedTotal += weight * position;
+			signalWeightTotal += weight;
+		}
+		if (signalWeightTotal > 0) return indexToAngle(weightedIndex(signalWeightedTotal, signalWeightTotal));
+	}
+
+	//Weighted centroid. Closer readings get more weight (groupMeanDistance / distance).
+	//With sample validation, the weight is also scaled by the confidence of the sample.
+	bool confidenceWeighting = (sampleValidation == true) && (fullFrameRead == true);
+	#ifdef FIXED_POINT_CENTROID
+	uint32_t weightedTotal = 0;
+	uint32_t weightTotal = 0;
+	#else
+	float weightedTotal = 0;
+	float weightTotal = 0;
+	#endif //FIXED_POINT_CENTROID
+	uint8_t groupReadings = 0;
+
+	for (uint16_t position = groupStartingIndex; position <= groupEndingPosition; position++)
+	{
+		uint8_t index = ringIndex(position);
+		if (distance[index] > 0)
+		{
+			#ifdef FIXED_POINT_CENTROID
+			uint32_t weight = ((uint32_t)groupMeanDistance << CENTROID_FRACTION_BITS) / (uint16_t)distance[index];
+			#else
+			float weight = (float)groupMeanDistance / (float)distance[index];
+			#endif //FIXED_POINT_CENTROID
+
+			if (confidenceWeighting == true)
+			{
+				#ifdef FIXED_POINT_CENTROID
+				weight = (weight * getSampleConfidence(index)) >> 8;
+				#else
+				weight = weight * getSampleConfidence(index) / 256;
+				#endif //FIXED_POINT_CENTROID
+			}
+
+			weightedTotal += weight * position;
+			weightTotal += weight;
+			groupReadings++;
+		}
+	}
+	if (groupReadings == 0) return 0;
+
+	/*
+	Confidence weights do not average to one, so with sample validation the centroid is normalized by the total weight.
+	So is a ring: positions of a wrapped group run up to twice the number of sensors, and dividing by the number of
+	readings would shift the centroid in proportion to the position of the group. A linear array keeps the plain average.
+	*/
+	bool normalizedCentroid = (confidenceWeighting == true) || (ringGeometry == true);
+	#ifdef FIXED_POINT_CENTROID
+	if (normalizedCentroid && (weightTotal > 0))
+	{
+		return indexToAngle(weightedIndex(weightedTotal, weightTotal));
+	}
+	return indexToAngle(weightedTotal / groupReadings);
+	#else
+	float centroidIndex = weightedTotal / groupReadings;
+	if (normalizedCentroid && (weightTotal > 0))
+	{
+		centroidIndex = weightedTotal / weightTotal;
+	}
+	return indexToAngle((int32_t)(centroidIndex * (1 << CENTROID_FRACTION_BITS) + 0.5));
+	#endif //FIXED_POINT_CENTROID
+}
+
+int16_t FuzzyRadar::indexToAngle(int32_t indexFixed)
+{
+	/*
+	Converts a fractional scan position in Q(CENTROID_FRACTION_BITS) to an angle in 0.1 degree units, rounded to nearest.
+	The angle is interpolated between the angles of the two neighbouring sensors in sensorAngle[].
+	In a ring, positions past the last sensor wrap to the first one. In a linear array, the distance centroid
+	can land past the last sensor, and the angle is extrapolated from the last two sensors instead.
+	*/
+	uint16_t position = indexFixed >> CENTROID_FRACTION_BITS;
+	if ((ringGeometry == false) && (position >= numberOfSensors - 1))
+	{
+		if (numberOfSensors < 2) return sensorAngle[0];
+		position = numberOfSensors - 2;
+	}
+	int32_t fraction = indexFixed - ((int32_t)position << CENTROID_FRACTION_BITS);
+	int16_t angle = sensorAngle[ringIndex(position)];
+	if (fraction == 0) return angle;
+
+	int32_t offsetFixed = (int32_t)getAngleDifference(sensorAngle[ringIndex(position + 1)], angle) * fraction;
+	int32_t half = (int32_t)1 << (CENTROID_FRACTION_BITS - 1);
+	return wrapAngle(angle + (offsetFixed + (offsetFixed >= 0 ? half : -half)) / ((int32_t)1 << CENTROID_FRACTION_BITS));
+}
+
+int16_t FuzzyRadar::wrapAngle(int32_t angleDecidegrees)
+{
+	//In a ring, brings the angle into 0 to FULL_TURN_DECIDEGREES - 1. Unchanged otherwise.
+	if (ringGeometry == false) return angleDecidegrees;
+	angleDecidegrees %= FULL_TURN_DECIDEGREES;
+	if (angleDecidegrees < 0) angleDecidegrees += FULL_TURN_DECIDEGREES;
+	return angleDecidegrees;
+}
+
+int16_t FuzzyRadar::getAngleDifference(int16_t angleA, int16_t angleB)
+{
+	//angleA - angleB. In a ring, the shorter way around, from -FULL_TURN_DECIDEGREES / 2 to FULL_TURN_DECIDEGREES / 2 - 1.
+	int16_t difference = angleA - angleB;
+	if (ringGeometry == true)
+	{
+		if (difference >= FULL_TURN_DECIDEGREES / 2) difference -= FULL_TURN_DECIDEGREES;
+		if (difference < -FULL_TURN_DECIDEGREES / 2) difference += FULL_TURN_DECIDEGREES;
+	}
+	return difference;
+}
+
+uint8_t FuzzyRadar::getScanStartingIndex()
+{
+	/*
+	First sensor of the grouping scans, which cover endingSensorIndex - startingSensorIndex + 1 sensors from there.
+	When a ring is scanned in full, the scan starts after the first sensor without a reading, so a target
+	across the last and the first sensor is seen as one group. A ring with a reading on every sensor is scanned from 0.
+	*/
+	if ((ringGeometry == false) || (startingSensorIndex > 0) || (endingSensorIndex < numberOfSensors - 1)) return startingSensorIndex;
+
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		if (distance[index] == 0) return ringIndex((uint16_t)index + 1);
+	}
+	return 0;
+}
+
+uint8_t FuzzyRadar::ringIndex(uint16_t position)
+{
+	//Sensor at a scan position, which counts on past the last sensor (up to twice the number of sensors).
+	return (position >= numberOfSensors) ? (position - numberOfSensors) : position;
+}
+
+uint32_t FuzzyRadar::weightedIndex(uint32_t weightedTotal, uint32_t weightTotal)
+{
+	//weightedTotal / weightTotal in Q(CENTROID_FRACTION_BITS). Quotient and remainder are scaled separately to stay within 32 bits.
+	uint32_t quotient = weightedTotal / weightTotal;
+	uint32_t remainder = weightedTotal % weightTotal;
+	return (quotient << CENTROID_FRACTION_BITS) + (remainder << CENTROID_FRACTION_BITS) / weightTotal;
+}
+
+int16_t FuzzyRadar::decidegreesToDegrees(int16_t decidegrees)
+{
+	//rounded to nearest, half away from zero
+	return (decidegrees + (decidegrees >= 0 ? 5 : -5)) / 10;
+}
+
+void FuzzyRadar::toCartesian(uint16_t range, int16_t angleDecidegrees, int16_t &x, int16_t &y)
+{
+	//range (mm) at angleDecidegrees to x/y (mm), see getXMM().
+	uint32_t planeRange = range;
+	if (mountingHeight > 0)
+	{
+		//slant range to the range on the floor plane
+		uint32_t rangeSquare = (uint32_t)range * range;
+		uint32_t heightSquare = (uint32_t)mountingHeight * mountingHeight;
+		planeRange = (rangeSquare > heightSquare) ? squareRoot(rangeSquare - heightSquare) : 0;
+	}
+
+	int32_t half = (int32_t)1 << (GEOMETRY_FRACTION_BITS - 1);
+	x = ((int32_t)planeRange * cosine(angleDecidegrees) + half) >> GEOMETRY_FRACTION_BITS;
+	y = ((int32_t)planeRange * sine(angleDecidegrees) + half) >> GEOMETRY_FRACTION_BITS;
+}
+
+int16_t FuzzyRadar::sine(int16_t angleDecidegrees)
+{
+	//Q(GEOMETRY_FRACTION_BITS). From the quarter wave table in 1 degree steps, interpolated to 0.1 degree.
+	int16_t angle = angleDecidegrees % FULL_TURN_DECIDEGREES;
+	if (angle < 0) angle += FULL_TURN_DECIDEGREES;
+	bool negative = (angle >= FULL_TURN_DECIDEGREES / 2);
+	if (negative) angle -= FULL_TURN_DECIDEGREES / 2;
+	if (angle > FULL_TURN_DECIDEGREES / 4) angle = FULL_TURN_DECIDEGREES / 2 - angle;
+
+	uint8_t degree = angle / 10;
+	uint8_t fraction = angle % 10;
+	int16_t value = pgm_read_word(&sineTable[degree]);
+	if (fraction > 0)
+	{
+		int16_t step = (int16_t)pgm_read_word(&sineTable[degree + 1]) - value;
+		value += (step * fraction + 5) / 10;
+	}
+	return negative ? -value : value;
+}
+
+int16_t FuzzyRadar::cosine(int16_t angleDecidegrees)
+{
+	return sine((angleDecidegrees % FULL_TURN_DECIDEGREES) + FULL_TURN_DECIDEGREES / 4);
+}
+
+int16_t FuzzyRadar::atan2Decidegree(int32_t y, int32_t x)
+{
+	/*
+	Angle of the point (x, y) in 0.1 degree units, from -1800 to 1800, like atan2().
+	The ratio of the shorter to the longer side is looked up in the arctangent table and interpolated.
+	*/
+	if ((x == 0) && (y == 0)) return 0;
+
+	uint32_t absoluteX = (x >= 0) ? x : -x;
+	uint32_t absoluteY = (y >= 0) ? y : -y;
+	bool steep = (absoluteY > absoluteX);
+	uint32_t longerSide = steep ? absoluteY : absoluteX;
+	uint32_t shorterSide = steep ? absoluteX : absoluteY;
+	while (longerSide >= ((uint32_t)1 << 18))
+	{
+		//keeps shorterSide << 13 within 32 bits
+		longerSide >>= 1;
+		shorterSide >>= 1;
+	}
+
+	uint16_t ratio = (shorterSide << 13) / longerSide; //Q13, so ratio >> 8 is the table index
+	uint8_t tableIndex = ratio >> 8;
+	uint8_t fraction = ratio & 0xFF;
+	int16_t angle = pgm_read_word(&arctangentTable[tableIndex]);
+	if (fraction > 0)
+	{
+		int16_t step = (int16_t)pgm_read_word(&arctangentTable[tableIndex + 1]) - angle;
+		angle += (step * fraction + 128) >> 8;
+	}
+
+	if (steep) angle = FULL_TURN_DECIDEGREES / 4 - angle;
+	if (x < 0) angle = FULL_TURN_DECIDEGREES / 2 - angle;
+	if (y < 0) angle = -angle;
+	return angle;
+}
+
+uint16_t FuzzyRadar::squareRoot(uint32_t value)
+{
+	//Integer square root, rounded down, bit by bit.
+	uint32_t root = 0;
+	uint32_t bit = (uint32_t)1 << 30;
+	while (bit > value) bit >>= 2;
+	while (bit != 0)
+	{
+		if (value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+void FuzzyRadar::calculateTargets()
+{
+	/*
+	Multi-target detection:
+	Every group of consecutive readings is a target. A group also ends where two neighbouring readings
+	differ by more than DEVIATION_THRESHOLD, so two objects at different depths are kept apart.
+	If there are more groups than MAXIMUM_TARGETS, the smallest (then farthest) targets are dropped.
+	*/
+	RadarTarget detectedTargets[MAXIMUM_TARGETS];
+	uint8_t numberOfDetectedTargets = 0;
+
+	uint8_t groupLength = 0;
+	uint8_t groupStartingIndex = 0;
+	uint32_t groupTotal = 0;
+	uint8_t scanStartingIndex = getScanStartingIndex();
+	uint8_t scanLength = endingSensorIndex - startingSensorIndex + 1;
+	uint8_t previousIndex = scanStartingIndex;
+	for (uint8_t position = 0; position < scanLength; position++)
+	{
+		uint8_t index = ringIndex((uint16_t)scanStartingIndex + position);
+		bool validReading = (distance[index] > 0);
+		if (validReading && (groupLength > 0) && (abs(distance[index] - distance[previousIndex]) > DEVIATION_THRESHOLD))
+		{
+			//depth jump, close the running group and start a new one at this index
+			addTarget(detectedTargets, numberOfDetectedTargets, groupStartingIndex, groupLength, groupTotal / groupLength);
+			groupLength = 0;
+		}
+
+		if (validReading)
+		{
+			if (groupLength == 0)
+			{
+				groupStartingIndex = index;
+				groupTotal = 0;
+			}
+			groupLength++;
+			groupTotal += distance[index];
+		}
+
+		if ((groupLength > 0) && ((validReading == false) || (position == scanLength - 1)))
+		{
+			addTarget(detectedTargets, numberOfDetectedTargets, groupStartingIndex, groupLength, groupTotal / groupLength);
+			groupLength = 0;
+		}
+		previousIndex = index;
+	}
+
+	for (uint8_t targetIndex = 0; targetIndex < numberOfDetectedTargets; targetIndex++)
+	{
+		RadarTarget &detected = detectedTargets[targetIndex];
+		detected.angle = calculateGroupAngle(detected.startingSensorIndex, detected.length, detected.meanDistance);
+		toCartesian(detected.meanDistance, detected.angle, detected.x, detected.y);
+	}
+
+	trackTargets(detectedTargets, numberOfDetectedTargets);
+}
+
+void FuzzyRadar::addTarget(RadarTarget *detectedTargets, uint8_t &numberOfDetectedTargets, uint8_t groupStartingIndex, uint8_t groupLength, uint16_t groupMeanDistance)
+{
+	uint8_t slot = numberOfDetectedTargets;
+	if (numberOfDetectedTargets == MAXIMUM_TARGETS)
+	{
+		//Buffer full, replace the weakest target (shortest, then farthest) if the new group beats it.
+		slot = 0;
+		for (uint8_t targetIndex = 1; targetIndex < MAXIMUM_TARGETS; targetIndex++)
+		{
+			if ((detectedTargets[targetIndex].length < detectedTargets[slot].length) ||
+				((detectedTargets[targetIndex].length == detectedTargets[slot].length) && (detectedTargets[targetIndex].meanDistance > detectedTargets[slot].meanDistance)))
+			{
+				slot = targetIndex;
+			}
+		}
+		if ((groupLength < detectedTargets[slot].length) ||
+			((groupLength == detectedTargets[slot].length) && (groupMeanDistance >= detectedTargets[slot].meanDistance)))
+		{
+			return;
+		}
+	}
+	else
+	{
+		numberOfDetectedTargets++;
+	}
+
+	detectedTargets[slot].id = 0;
+	detectedTargets[slot].startingSensorIndex = groupStartingIndex;
+	detectedTargets[slot].length = groupLength;
+	detectedTargets[slot].meanDistance = groupMeanDistance;
+	detectedTargets[slot].angle = 0;
+	detectedTargets[slot].x = 0;
+	detectedTargets[slot].y = 0;
+	detectedTargets[slot].missedFrames = 0;
+}
+
+void FuzzyRadar::trackTargets(RadarTarget *detectedTargets, uint8_t numberOfDetectedTargets)
+{
+	/*
+	Frame-to-frame association:
+	Each detected target takes the ID of the closest unmatched target of the previous frame, if it is within
+	TARGET_ASSOCIATION_ANGLE and TARGET_ASSOCIATION_DISTANCE. Otherwise it gets a new ID.
+	A previous target that is not detected again is kept, at its last position, for up to
+	TRACKING_MAXIMUM_MISSED_FRAMES frames, as the tracking filter of the primary target does,
+	so a single missed frame does not cost it its ID. Detected targets take precedence for the slots.
+	A target outside of the adaptive region of interest was not looked for, so it is kept without counting a miss.
+	*/
+	bool matched[MAXIMUM_TARGETS] = { false };
+
+	for (uint8_t targetIndex = 0; targetIndex < numberOfDetectedTargets; targetIndex++)
+	{
+		RadarTarget &detected = detectedTargets[targetIndex];
+		uint8_t bestMatch = MAXIMUM_TARGETS;
+		uint32_t bestCost = 0xFFFFFFFF;
+
+		for (uint8_t previousIndex = 0; previousIndex < numberOfTargets; previousIndex++)
+		{
+			if (matched[previousIndex] == true) continue;
+
+			uint16_t angleDifference = abs(getAngleDifference(detected.angle, targets[previousIndex].angle)); //0.1 degree
+			uint16_t distanceDifference = abs((int16_t)detected.meanDistance - (int16_t)targets[previousIndex].meanDistance);
+			if ((angleDifference > TARGET_ASSOCIATION_ANGLE * 10) || (distanceDifference > TARGET_ASSOCIATION_DISTANCE)) continue;
+
+			//Both differences normalized to their gate.
+			uint32_t cost = (uint32_t)angleDifference * TARGET_ASSOCIATION_DISTANCE + (uint32_t)distanceDifference * TARGET_ASSOCIATION_ANGLE * 10;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestMatch = previousIndex;
+			}
+		}
+
+		if (bestMatch < MAXIMUM_TARGETS)
+		{
+			detected.id = targets[bestMatch].id;
+			matched[bestMatch] = true;
+		}
+		else
+		{
+			detected.id = nextTargetId;
+			nextTargetId++;
+			if (nextTargetId == 0) nextTargetId = 1; //0 is never used as an ID
+		}
+	}
+
+	for (uint8_t previousIndex = 0; previousIndex < numberOfTargets; previousIndex++)
+	{
+		if ((matched[previousIndex] == true) || (numberOfDetectedTargets == MAXIMUM_TARGETS)) continue;
+		bool scanned = isInRegionOfInterest(targets[previousIndex]);
+		if (scanned && (targets[previousIndex].missedFrames >= TRACKING_MAXIMUM_MISSED_FRAMES)) continue; //lost, its ID is freed
+
+		detectedTargets[numberOfDetectedTargets] = targets[previousIndex];
+		if (scanned) detectedTargets[numberOfDetectedTargets].missedFrames++;
+		numberOfDetectedTargets++;
+	}
+
+	for (uint8_t targetIndex = 0; targetIndex < numberOfDetectedTargets; targetIndex++)
+	{
+		targets[targetIndex] = detectedTargets[targetIndex];
+	}
+	numberOfTargets = numberOfDetectedTargets;
+}
+
+bool FuzzyRadar::isInRegionOfInterest(const RadarTarget &target)
+{
+	//True if at least one sensor of the target was read in this frame.
+	for (uint16_t position = target.startingSensorIndex; position < (uint16_t)target.startingSensorIndex + target.length; position++)
+	{
+		uint8_t index = ringIndex(position);
+		if ((index >= startingSensorIndex) && (index <= endingSensorIndex)) return true;
 	}
-
-	Serial.println();
-	#endif //DEBUG_PRINT_DISTANCE_ANGLE
-
-	hasNewData = true;
+	return false;
 }
 
 void FuzzyRadar::printRawData()
@@ -461,8 +1724,6 @@ void FuzzyRadar::resetDataValues()
 	numberOfReadings = 0;
 	total = 0;
 	meanDistance = 0;
-	weightedTotal = 0;
-	weightedIndex = 0;
 	angle = 0;
 }
 
@@ -508,4 +1769,677 @@ void FuzzyRadar::clearDataValues()
 void FuzzyRadar::setMaximumRangeMM(int16_t _maximumRange)
 {
 	maximumRange = _maximumRange;
-}
\ No newline at end of file
+}
+
+void FuzzyRadar::setRingGeometry(bool _ringGeometry)
+{
+	/*
+	Must be called before begin(). The sensors cover a full turn. With begin(xshutnPin, seperation), they are evenly
+	spaced and the seperation is not used: sensor 0 points at 0 degree and the angle goes down with the index, as in
+	a linear array, so sensor 1 is at 360 - 360 / numberOfSensors. With an azimuth table, the table is used.
+	Groups of readings wrap from the last sensor to the first, and angles are reported from 0 to 359.9 degree.
+	*/
+	ringGeometry = _ringGeometry;
+}
+
+void FuzzyRadar::setBus(TwoWire *_bus)
+{
+	//Must be called before begin(). All sensors in the array share this bus.
+	buses[0] = _bus;
+	numberOfBuses = 1;
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		sensor[index].setBus(_bus);
+	}
+}
+
+bool FuzzyRadar::setBus(uint8_t index, TwoWire *_bus)
+{
+	/*
+	Must be called before begin(). Moves one sensor to another TwoWire bus, e.g. Wire1 on boards that have a
+	second I2C port. Returns false if the array would use more than MAXIMUM_BUSES buses.
+	The XSHUT chain is not affected, the sensors are still enabled one after the other in index order.
+	*/
+	if (index >= numberOfSensors) return false;
+	if (addBus(_bus) >= MAXIMUM_BUSES) return false;
+	sensor[index].setBus(_bus);
+	return true;
+}
+
+bool FuzzyRadar::setBuses(TwoWire * const *_buses, uint8_t _numberOfBuses)
+{
+	/*
+	Must be called before begin(). Splits the array into _numberOfBuses blocks of consecutive sensors,
+	the first block on _buses[0], the next on _buses[1], and so on.
+	*/
+	if ((_numberOfBuses == 0) || (_numberOfBuses > MAXIMUM_BUSES)) return false;
+	numberOfBuses = 0;
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		TwoWire *sensorBus = _buses[(uint16_t)index * _numberOfBuses / numberOfSensors];
+		addBus(sensorBus);
+		sensor[index].setBus(sensorBus);
+	}
+	return true;
+}
+
+uint8_t FuzzyRadar::addBus(TwoWire *_bus)
+{
+	//Index of _bus in buses[], added if it is new. MAXIMUM_BUSES if there is no room left.
+	for (uint8_t lane = 0; lane < numberOfBuses; lane++)
+	{
+		if (buses[lane] == _bus) return lane;
+	}
+	if (numberOfBuses >= MAXIMUM_BUSES) return MAXIMUM_BUSES;
+	buses[numberOfBuses] = _bus;
+	return numberOfBuses++;
+}
+
+uint8_t FuzzyRadar::getNumberOfBuses()
+{
+	return numberOfBuses;
+}
+
+bool FuzzyRadar::setMultiplexer(uint8_t _multiplexerAddress, uint8_t _sensorsPerChannel)
+{
+	/*
+	Must be called before begin(). The array sits behind a TCA9548A-style I2C multiplexer (at the same
+	address on every bus in use), in blocks of _sensorsPerChannel consecutive sensors: sensor index is on
+	channel index / _sensorsPerChannel. I2C addresses are assigned per bus and channel, so each channel
+	takes up to SENSOR_ADDRESS_COUNT (103) sensors per bus, or begin() fails.
+	Sensors are read in index order, so a sweep switches each channel only once.
+	Pass _sensorsPerChannel = 0 to remove the multiplexer. Returns false if more than
+	MAXIMUM_MULTIPLEXER_CHANNELS channels would be needed.
+	*/
+	if ((_sensorsPerChannel > 0) && ((numberOfSensors - 1) / _sensorsPerChannel >= MAXIMUM_MULTIPLEXER_CHANNELS)) return false;
+	multiplexerAddress = _multiplexerAddress;
+	sensorsPerChannel = _sensorsPerChannel;
+	return true;
+}
+
+uint8_t FuzzyRadar::getChannel(uint8_t index)
+{
+	if (sensorsPerChannel == 0) return 0;
+	return index / sensorsPerChannel;
+}
+
+void FuzzyRadar::selectChannel(uint8_t index)
+{
+	//Enables the multiplexer channel of sensor[index] on its bus, unless it is enabled already.
+	if (sensorsPerChannel == 0) return;
+
+	uint8_t channel = getChannel(index);
+	TwoWire *bus = sensor[index].getBus();
+	uint8_t lane = 0;
+	while ((lane < numberOfBuses) && (buses[lane] != bus)) lane++;
+	if ((lane < numberOfBuses) && (selectedChannel[lane] == channel)) return;
+
+	bus->beginTransmission(multiplexerAddress);
+	bus->write(1 << channel);
+	bool channelSelected = (bus->endTransmission() == 0);
+	#ifdef FUZZY_RADAR_INSTRUMENTATION
+	statistics.busBytes += 2;
+	if (channelSelected == false) statistics.busErrors++;
+	#endif //FUZZY_RADAR_INSTRUMENTATION
+	if (lane < numberOfBuses) selectedChannel[lane] = (channelSelected == true) ? channel : 0xFF;
+}
+
+uint8_t FuzzyRadar::planAddress(uint8_t index)
+{
+	/*
+	I2C address of sensor[index]. The sensors sharing a bus and multiplexer channel are numbered in index
+	order, and take consecutive addresses from STARTING_ADDRESS up to MAXIMUM_SENSOR_ADDRESS, then from
+	MINIMUM_SENSOR_ADDRESS on, skipping DEFAULT_SENSOR_ADDRESS. That is SENSOR_ADDRESS_COUNT addresses.
+	Returns 0 past them: a larger group would reuse addresses, so it has to be split with setBuses() or setMultiplexer().
+	*/
+	uint8_t position = 0;
+	for (uint8_t other = 0; other < index; other++)
+	{
+		if ((sensor[other].getBus() == sensor[index].getBus()) && (getChannel(other) == getChannel(index))) position++;
+	}
+	if (position >= SENSOR_ADDRESS_COUNT) return 0;
+
+	uint8_t sensorAddress = STARTING_ADDRESS;
+	while (true)
+	{
+		if (sensorAddress > MAXIMUM_SENSOR_ADDRESS) sensorAddress = MINIMUM_SENSOR_ADDRESS;
+		if (sensorAddress != DEFAULT_SENSOR_ADDRESS)
+		{
+			if (position == 0) break;
+			position--;
+		}
+		sensorAddress++;
+	}
+	return sensorAddress;
+}
+
+void FuzzyRadar::setFullFrameRead(bool _fullFrameRead)
+{
+	/*
+	When enabled, readData() pulls the 12-byte RESULT_RANGE_STATUS block of each sensor
+	in one readMulti() burst instead of only the 2-byte range, so range status, signal rate,
+	ambient rate and effective SPAD count are available through getRangingData().
+	*/
+	if ((_fullFrameRead == true) && (rangingData == NULL))
+	{
+		rangingData = new VL53L0X::RangingData[numberOfSensors];
+		memset(rangingData, 0, sizeof(VL53L0X::RangingData) * numberOfSensors);
+	}
+	fullFrameRead = _fullFrameRead;
+}
+
+void FuzzyRadar::setSampleValidation(bool _sampleValidation, float _minimumSignalRateMCPS, float _maximumAmbientRateMCPS)
+{
+	/*
+	When enabled, every sample is checked with the range status, signal rate and ambient rate of the device
+	before it is used. Samples with a failed device range status (signal, phase/wrap-around, hardware or
+	minimum range fail), the 8190/8191 no target codes, a signal rate below _minimumSignalRateMCPS or
+	an ambient rate above _maximumAmbientRateMCPS are reported as no reading, with their SAMPLE_STATUS_*.
+	With _minimumSignalRateMCPS = 0 (SAMPLE_MINIMUM_SIGNAL_RATE), each sensor uses the signal rate limit of its
+	ranging profile: LONG_RANGE_SIGNAL_RATE_LIMIT for RANGING_PROFILE_LONG_RANGE, DEFAULT_SIGNAL_RATE_LIMIT otherwise.
+	The angle centroid also weights every sensor with the share of its return signal in its total rate.
+	Enables setFullFrameRead(), which provides the status and rates.
+	*/
+	if (_sampleValidation == true) setFullFrameRead(true);
+	sampleValidation = _sampleValidation;
+	minimumSignalRate = _minimumSignalRateMCPS * (1 << 7);
+	maximumAmbientRate = _maximumAmbientRateMCPS * (1 << 7);
+}
+
+void FuzzyRadar::setAdaptiveRegionOfInterest(bool _adaptiveRegionOfInterest)
+{
+	/*
+	When enabled, only the sensors of the tracked target and ROI_MARGIN sensors on each side are read
+	while a target is found. The whole array is still read every ROI_FULL_SCAN_INTERVAL frames to pick up
+	new or larger targets, and as soon as the target is lost. Sensors outside of the window are reported
+	as SAMPLE_STATUS_MISSING. Multi-target tracking only sees targets outside of the window on full scans,
+	and reports them at their last position, with their ID, in between.
+	*/
+	adaptiveRegionOfInterest = _adaptiveRegionOfInterest;
+	if (adaptiveRegionOfInterest == false)
+	{
+		startingSensorIndex = 0;
+		endingSensorIndex = numberOfSensors - 1;
+	}
+}
+
+void FuzzyRadar::updateRegionOfInterest()
+{
+	//Picks the sensors to read in the next frame. Only the primary group is left in distance[] by now.
+	uint8_t groupStartingIndex = endingSensorIndex + 1;
+	uint8_t groupEndingIndex = 0;
+	for (uint8_t index = startingSensorIndex; index <= endingSensorIndex; index++)
+	{
+		if (distance[index] == 0) continue;
+		if (groupStartingIndex > endingSensorIndex) groupStartingIndex = index;
+		groupEndingIndex = index;
+	}
+
+	fullScanCounter++;
+	if ((groupStartingIndex > endingSensorIndex) || (fullScanCounter >= ROI_FULL_SCAN_INTERVAL))
+	{
+		//target lost, or time for a full scan
+		fullScanCounter = 0;
+		startingSensorIndex = 0;
+		endingSensorIndex = numberOfSensors - 1;
+		return;
+	}
+
+	startingSensorIndex = (groupStartingIndex > ROI_MARGIN) ? (groupStartingIndex - ROI_MARGIN) : 0;
+	endingSensorIndex = ((uint16_t)groupEndingIndex + ROI_MARGIN < numberOfSensors) ? (groupEndingIndex + ROI_MARGIN) : (numberOfSensors - 1);
+}
+
+void FuzzyRadar::setBinaryOutput(Print *_binaryOutput)
+{
+	/*
+	Writes every published frame to _binaryOutput (usually Serial) as one binary packet, little endian:
+	  sync      2 bytes  BINARY_FRAME_SYNC_0, BINARY_FRAME_SYNC_1
+	  sequence  uint16   incremented for every frame, to detect dropped packets
+	  timestamp uint32   millis() when the frame was published
+	  sensors   uint8    number of sensors n
+	  distance  n x uint16  raw distance (mm) before the deviation and noise filters, 0 for no reading
+	  status    (n+1)/2 bytes  SAMPLE_STATUS_* of each sensor, 4 bits each, sensor 0 in the low nibble
+	  angle     int16    filtered angle (0.1 degree)
+	  distance  uint16   filtered distance (mm)
+	  crc       uint16   CRC-16/CCITT-FALSE of every byte after the sync word
+	The whole packet, BINARY_FRAME_SIZE(n) bytes, is passed to a single write() call.
+	extras/fuzzy_radar_decode.py decodes the stream on the host.
+	Pass NULL to stop the output.
+	*/
+	if ((_binaryOutput != NULL) && (binaryFrame == NULL))
+	{
+		binaryFrame = new uint8_t[BINARY_FRAME_SIZE(numberOfSensors)];
+	}
+	binaryOutput = _binaryOutput;
+}
+
+bool FuzzyRadar::setFrameBuffer(RadarFrameBuffer *_frameBuffer)
+{
+	/*
+	Every published frame is also stored in _frameBuffer, with the raw samples, the filtered result and
+	the targets of multi-target tracking. The buffer must be made for the same number of sensors.
+	Pass NULL to stop storing frames.
+	*/
+	if ((_frameBuffer != NULL) && (_frameBuffer->getNumberOfSensors() != numberOfSensors)) return false;
+	frameBuffer = _frameBuffer;
+	return true;
+}
+
+VL53L0X::RangingData FuzzyRadar::getRangingData(uint8_t index)
+{
+	//Only meaningful when full frame read is enabled. Returns an all-zero record otherwise.
+	VL53L0X::RangingData data;
+	memset(&data, 0, sizeof(data));
+	if ((rangingData != NULL) && (index < numberOfSensors))
+	{
+		data = rangingData[index];
+	}
+	return data;
+}
+
+void FuzzyRadar::setReadMode(ReadMode _readMode)
+{
+	readMode = _readMode;
+
+	//Restart frame assembly so no sample is carried over from the previous mode.
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		sensorFlags[index] &= ~SENSOR_FLAG_FRESH_SAMPLE;
+	}
+	freshSampleCount = 0;
+	pollIndex = 0;
+	sweepInProgress = false;
+	readDataTimer = millis();
+}
+
+void FuzzyRadar::setRangingPhases(uint8_t _rangingPhases, uint16_t _targetFramePeriodMS)
+{
+	/*
+	Must be called before begin().
+	_rangingPhases = 1 keeps all sensors in continuous mode (default).
+	_rangingPhases = N fires the sensors in N interleaved groups (index % N) to avoid crosstalk between neighbours.
+	A frame is published after every group, so each sensor delivers a sample every N frames.
+	_targetFramePeriodMS, if given, sets the timing budget so that one group, and so one frame, takes this long.
+	It cannot go below the 20 ms minimum timing budget plus STAGGER_MARGIN.
+	*/
+	rangingPhases = (_rangingPhases > 0) ? _rangingPhases : 1;
+	targetFramePeriod = _targetFramePeriodMS;
+	if ((rangingPhases > 1) && (heldDistance == NULL))
+	{
+		heldDistance = new int16_t[numberOfSensors];
+		memset(heldDistance, 0, sizeof(int16_t) * numberOfSensors);
+	}
+}
+
+void FuzzyRadar::setRangingProfile(RangingProfile _rangingProfile)
+{
+	//Must be called before begin(). Applies the profile to every sensor.
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		setRangingProfile(index, _rangingProfile);
+	}
+}
+
+void FuzzyRadar::setRangingProfile(uint8_t index, RangingProfile _rangingProfile)
+{
+	//Must be called before begin(). The frame period follows the slowest sensor.
+	if (index >= numberOfSensors) return;
+	sensorFlags[index] = (sensorFlags[index] & ~SENSOR_PROFILE_MASK) | ((uint8_t)_rangingProfile << SENSOR_PROFILE_SHIFT);
+}
+
+FuzzyRadar::RangingProfile FuzzyRadar::getRangingProfile(uint8_t index)
+{
+	return (RangingProfile)((sensorFlags[index] & SENSOR_PROFILE_MASK) >> SENSOR_PROFILE_SHIFT);
+}
+
+uint32_t FuzzyRadar::applyRangingProfile(uint8_t index)
+{
+	//Configures sensor[index] for its profile. Returns the timing budget (us), or 0 for RANGING_PROFILE_DEFAULT.
+	switch (getRangingProfile(index))
+	{
+	case RANGING_PROFILE_HIGH_SPEED:
+		sensor[index].setMeasurementTimingBudget(20000);
+		return 20000;
+
+	case RANGING_PROFILE_LONG_RANGE:
+		//lower the return signal rate limit (default is DEFAULT_SIGNAL_RATE_LIMIT) and use longer laser pulses
+		sensor[index].setSignalRateLimit(LONG_RANGE_SIGNAL_RATE_LIMIT);
+		sensor[index].setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange, 18);
+		sensor[index].setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange, 14);
+		return sensor[index].getMeasurementTimingBudget();
+
+	case RANGING_PROFILE_HIGH_ACCURACY:
+		sensor[index].setMeasurementTimingBudget(200000);
+		return 200000;
+
+	default:
+		return 0;
+	}
+}
+
+void FuzzyRadar::updateFramePeriod()
+{
+	uint32_t now = millis();
+	uint16_t period = now - frameTimer;
+	frameTimer = now;
+
+	if (framePeriodRegister == 0)
+	{
+		framePeriodRegister = period << FRAME_PERIOD_FILTER_SHIFT;
+	}
+	else
+	{
+		framePeriodRegister = framePeriodRegister - (framePeriodRegister >> FRAME_PERIOD_FILTER_SHIFT) + period;
+	}
+}
+
+uint16_t FuzzyRadar::getFramePeriodMS()
+{
+	return framePeriodRegister >> FRAME_PERIOD_FILTER_SHIFT;
+}
+
+float FuzzyRadar::getFrameRate()
+{
+	uint16_t framePeriod = getFramePeriodMS();
+	if (framePeriod == 0) return 0;
+	return 1000.0 / framePeriod;
+}
+
+uint16_t FuzzyRadar::getSampleAgeMS(uint8_t index)
+{
+	//Time since the sample currently held for this sensor was read.
+	return (uint16_t)millis() - sampleTime[index];
+}
+
+uint16_t FuzzyRadar::getStartupTimeMS()
+{
+	//Time spent in begin(), from power-up of the first chip to the start of ranging.
+	return startupTime;
+}
+
+void FuzzyRadar::setCalibrationData(const uint8_t *_calibrationData)
+{
+	/*
+	Must be called before begin(), and the data must stay valid until begin() returns.
+	_calibrationData holds numberOfSensors blobs of VL53L0X::CalibrationDataSize bytes, in sensor order,
+	as saved with getCalibrationData() (e.g. kept in EEPROM). Sensors whose blob is corrupt or does not
+	match their address fall back to the full initialization and reference calibration.
+	*/
+	calibrationData = _calibrationData;
+}
+
+void FuzzyRadar::getCalibrationData(uint8_t index, uint8_t *blob)
+{
+	//Call after begin(). blob must hold VL53L0X::CalibrationDataSize bytes.
+	selectChannel(index);
+	sensor[index].getCalibrationData(blob);
+}
+
+void FuzzyRadar::setMultiTargetTracking(bool _multiTargetTracking)
+{
+	/*
+	When enabled, every group of readings in a frame is reported as a target with a stable ID,
+	through getNumberOfTargets() and getTarget(). A target that is not detected in a frame is still
+	reported, at its last position and with RadarTarget::missedFrames counting up, until it has been
+	missed for TRACKING_MAXIMUM_MISSED_FRAMES frames. getAngleDegree() and getDistanceMM() still
+	report the primary target only.
+	*/
+	multiTargetTracking = _multiTargetTracking;
+	numberOfTargets = 0;
+}
+
+uint8_t FuzzyRadar::getNumberOfTargets()
+{
+	return numberOfTargets;
+}
+
+RadarTarget FuzzyRadar::getTarget(uint8_t targetIndex)
+{
+	//targetIndex from 0 to getNumberOfTargets() - 1. Returns an all-zero target (ID 0) otherwise.
+	RadarTarget target;
+	memset(&target, 0, sizeof(target));
+	if (targetIndex < numberOfTargets)
+	{
+		target = targets[targetIndex];
+	}
+	return target;
+}
+
+int16_t FuzzyRadar::getDistanceVelocity()
+{
+	//mm per second, positive when the target moves away. Always 0 without TRACKING_FILTER.
+	#ifdef TRACKING_FILTER
+	uint16_t framePeriod = getFramePeriodMS();
+	if (framePeriod == 0) return 0;
+	return (distanceVelocity * 1000 / framePeriod) >> TRACKING_FRACTION_BITS;
+	#else
+	return 0;
+	#endif //TRACKING_FILTER
+}
+
+int16_t FuzzyRadar::getAngleVelocity()
+{
+	//Degrees per second. Always 0 without TRACKING_FILTER.
+	#ifdef TRACKING_FILTER
+	uint16_t framePeriod = getFramePeriodMS();
+	if (framePeriod == 0) return 0;
+	return (angleVelocity * 100 / framePeriod) >> TRACKING_FRACTION_BITS; //angleVelocity is in 0.1 degree per frame
+	#else
+	return 0;
+	#endif //TRACKING_FILTER
+}
+
+uint16_t FuzzyRadar::getPredictedDistanceMM()
+{
+	//Expected distance at the next frame. Same as getDistanceMM() without TRACKING_FILTER.
+	hasNewData = false;
+	#ifdef TRACKING_FILTER
+	if (filteredMeanDistance == 0) return 0;
+	int32_t predictedPosition = distancePosition + distanceVelocity;
+	return (predictedPosition > 0) ? (predictedPosition >> TRACKING_FRACTION_BITS) : 0;
+	#else
+	return filteredMeanDistance;
+	#endif //TRACKING_FILTER
+}
+
+int16_t FuzzyRadar::getPredictedAngleDegree()
+{
+	//Expected angle at the next frame. Same as getAngleDegree() without TRACKING_FILTER.
+	return decidegreesToDegrees(getPredictedAngleDecidegree());
+}
+
+int16_t FuzzyRadar::getPredictedAngleDecidegree()
+{
+	//Expected angle at the next frame, in 0.1 degree units.
+	hasNewData = false;
+	#ifdef TRACKING_FILTER
+	if (filteredMeanDistance == 0) return 0;
+	return wrapAngle((anglePosition + angleVelocity) >> TRACKING_FRACTION_BITS);
+	#else
+	return filteredAngle;
+	#endif //TRACKING_FILTER
+}
+
+void FuzzyRadar::setAngleEstimator(AngleEstimator _angleEstimator)
+{
+	//The signal estimators need the signal rate and SPAD count of the full frame read.
+	if ((_angleEstimator == ANGLE_ESTIMATOR_SIGNAL_WEIGHTED) || (_angleEstimator == ANGLE_ESTIMATOR_SIGNAL_PER_SPAD)) setFullFrameRead(true);
+	angleEstimator = _angleEstimator;
+}
+
+#ifdef FUZZY_RADAR_INSTRUMENTATION
+const RadarStatistics &FuzzyRadar::getStatistics()
+{
+	return statistics;
+}
+
+void FuzzyRadar::resetStatistics()
+{
+	memset(&statistics, 0, sizeof(statistics));
+	statistics.busTime.minimum = 0xFFFFFFFF;
+	statistics.acquisitionTime.minimum = 0xFFFFFFFF;
+	statistics.computeTime.minimum = 0xFFFFFFFF;
+	statistics.outputTime.minimum = 0xFFFFFFFF;
+	statistics.frameLatency.minimum = 0xFFFFFFFF;
+	frameStarted = false;
+	frameBusTime = 0;
+}
+
+void FuzzyRadar::recordBusTransfer(uint8_t index, uint8_t bytes, uint32_t startTime)
+{
+	//Called right after a transaction with sensor[index] that started at startTime (us).
+	uint32_t now = micros();
+	if (frameStarted == false)
+	{
+		frameStarted = true;
+		frameStartTime = startTime;
+	}
+	frameBusTime += now - startTime;
+	statistics.busBytes += bytes;
+	if (sensor[index].last_status != 0) statistics.busErrors++;
+}
+
+void FuzzyRadar::recordTimer(RadarTimer &timer, uint32_t value)
+{
+	if (value < timer.minimum) timer.minimum = value;
+	if (value > timer.maximum) timer.maximum = value;
+	timer.total += value;
+	timer.count++;
+}
+#endif //FUZZY_RADAR_INSTRUMENTATION
+
+void FuzzyRadar::packBinarySamples()
+{
+	uint8_t *samples = binaryFrame + 9;
+	uint8_t *statuses = samples + 2 * numberOfSensors;
+	memset(statuses, 0, (numberOfSensors + 1) / 2);
+
+	for (uint8_t index = 0; index < numberOfSensors; index++)
+	{
+		uint16_t sample = ((index >= startingSensorIndex) && (index <= endingSensorIndex)) ? distance[index] : 0;
+		uint8_t status = getSampleStatus(index);
+
+		samples[2 * index] = sample;
+		samples[2 * index + 1] = sample >> 8;
+		statuses[index >> 1] |= status << ((index & 0x01) ? 4 : 0);
+	}
+}
+
+void FuzzyRadar::writeBinaryFrame()
+{
+	uint16_t length = BINARY_FRAME_SIZE(numberOfSensors);
+	uint32_t timestamp = millis();
+
+	binaryFrame[0] = BINARY_FRAME_SYNC_0;
+	binaryFrame[1] = BINARY_FRAME_SYNC_1;
+	binaryFrame[2] = frameSequence;
+	binaryFrame[3] = frameSequence >> 8;
+	binaryFrame[4] = timestamp;
+	binaryFrame[5] = timestamp >> 8;
+	binaryFrame[6] = timestamp >> 16;
+	binaryFrame[7] = timestamp >> 24;
+	binaryFrame[8] = numberOfSensors;
+	//distance and status fields are filled in by packBinarySamples()
+
+	uint8_t *result = binaryFrame + length - 6;
+	result[0] = filteredAngle;
+	result[1] = filteredAngle >> 8;
+	result[2] = filteredMeanDistance;
+	result[3] = filteredMeanDistance >> 8;
+
+	uint16_t crc = crc16(binaryFrame + 2, length - 4);
+	result[4] = crc;
+	result[5] = crc >> 8;
+
+	binaryOutput->write(binaryFrame, length);
+}
+
+uint16_t FuzzyRadar::crc16(const uint8_t *data, uint16_t length)
+{
+	//CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+	uint16_t crc = 0xFFFF;
+	for (uint16_t index = 0; index < length; index++)
+	{
+		crc ^= (uint16_t)data[index] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+RadarFrameBuffer::RadarFrameBuffer(uint8_t _numberOfSensors, uint8_t _capacity, RadarFrame *_slots, int16_t *_sampleDistance, uint8_t *_sampleStatus)
+{
+	//Buffers are provided by StaticRadarFrameBuffer<N, LENGTH>.
+	numberOfSensors = _numberOfSensors;
+	numberOfSlots = _capacity + 1;
+	slots = _slots;
+	for (uint8_t slot = 0; slot < numberOfSlots; slot++)
+	{
+		slots[slot].sampleDistance = _sampleDistance + slot * numberOfSensors;
+		slots[slot].sampleStatus = _sampleStatus + slot * numberOfSensors;
+	}
+	head = 0;
+	tail = 0;
+	overruns = 0;
+}
+
+uint8_t RadarFrameBuffer::getNumberOfSensors()
+{
+	return numberOfSensors;
+}
+
+uint8_t RadarFrameBuffer::getCapacity()
+{
+	return numberOfSlots - 1;
+}
+
+uint8_t RadarFrameBuffer::available()
+{
+	//Number of frames waiting to be read.
+	uint8_t currentHead = head;
+	uint8_t currentTail = tail;
+	return (currentHead >= currentTail) ? (currentHead - currentTail) : (numberOfSlots - currentTail + currentHead);
+}
+
+const RadarFrame *RadarFrameBuffer::peek()
+{
+	//Oldest frame, or NULL when empty. The frame stays valid until pop().
+	if (tail == head) return NULL;
+	//The slot contents must not be read before head shows that the producer has published them.
+	__asm__ __volatile__("" ::: "memory");
+	return &slots[tail];
+}
+
+void RadarFrameBuffer::pop()
+{
+	if (tail == head) return;
+	//Reading the frame must be done before the slot is handed back to the producer.
+	__asm__ __volatile__("" ::: "memory");
+	tail = (tail + 1 < numberOfSlots) ? (tail + 1) : 0;
+}
+
+uint16_t RadarFrameBuffer::getOverruns()
+{
+	return overruns;
+}
+
+RadarFrame *RadarFrameBuffer::claim()
+{
+	//Producer side: slot to fill for the next frame, or NULL when the buffer is full.
+	uint8_t nextHead = (head + 1 < numberOfSlots) ? (head + 1) : 0;
+	if (nextHead == tail)
+	{
+		overruns++;
+		return NULL;
+	}
+	return &slots[head];
+}
+
+void RadarFrameBuffer::publish()
+{
+	//Producer side: makes the slot returned by claim() visible to the consumer.
+	__asm__ __volatile__("" ::: "memory");
+	head = (head + 1 < numberOfSlots) ? (head + 1) : 0;
+}
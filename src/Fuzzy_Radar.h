@@ -9,7 +9,7 @@
 #define _Fuzzy_Radar_h
 
 #if defined(ARDUINO) && ARDUINO >= 100
-	#include "arduino.h"
+	#include "Arduino.h"
 #else
 	#include "WProgram.h"
 #endif
@@ -23,11 +23,80 @@
 #define DEFAULT_MAXIMUM_RANGE 900
 #define DEVIATION_THRESHOLD 200 //signals are removed if the readings is more than this threshold value (mm)
 #define STARTING_ADDRESS 0x53
-#define READ_DATA_DURATION 24
-#define MEAN_DISTANCE_FILTER_SHIFT 1
+#define MINIMUM_SENSOR_ADDRESS 0x08 //0x00-0x07 are reserved I2C addresses.
+#define MAXIMUM_SENSOR_ADDRESS 0x6F //0x70-0x77 are left for I2C multiplexers, 0x78-0x7F are reserved.
+#define DEFAULT_SENSOR_ADDRESS 0x29 //VL53L0X address after reset, never assigned.
+#define SENSOR_ADDRESS_COUNT (MAXIMUM_SENSOR_ADDRESS - MINIMUM_SENSOR_ADDRESS) //103, addresses in the range above without DEFAULT_SENSOR_ADDRESS.
+#define MAXIMUM_BUSES 4 //Number of I2C buses an array can be split across, see setBuses().
+#define MAXIMUM_MULTIPLEXER_CHANNELS 8 //TCA9548A, see setMultiplexer().
+#define READ_DATA_DURATION 24 //Frame period (ms) when every sensor uses RANGING_PROFILE_DEFAULT.
+#define PROFILE_READ_MARGIN 2 //Time (ms) added to the slowest timing budget to get the frame period with other ranging profiles.
+#define DEFAULT_SIGNAL_RATE_LIMIT 0.25 //MCPS, final range signal rate limit of the VL53L0X after init()
+#define LONG_RANGE_SIGNAL_RATE_LIMIT 0.1 //MCPS, signal rate limit of RANGING_PROFILE_LONG_RANGE
+#define CALIBRATION_TIMEOUT 500 //Time (ms) to wait for the reference calibration of all sensors in begin().
+#define STAGGER_MARGIN 2 //Time (ms) added to the timing budget of each ranging phase when sensors are fired in interleaved groups.
+#define STAGGER_MINIMUM_TIMING_BUDGET 20000 //us, shortest VL53L0X timing budget, which limits the phase duration.
+#define FRAME_PERIOD_FILTER_SHIFT 2
+#define DATA_READY_TIMEOUT 40 //In data-ready read mode, a frame is published with the sensors that are ready once this time (ms) has passed.
+#define DATA_READY_POLL_MARGIN 4 //In data-ready read mode, a sensor is polled from this time (ms) before its next sample is due.
+#define MEAN_DISTANCE_FILTER_SHIFT 1 //Output IIR filter, used when TRACKING_FILTER is disabled.
 #define ANGLE_FILTER_SHIFT 1
+#define TRACKING_FRACTION_BITS 4
+#define TRACKING_ALPHA_SHIFT 1 //alpha = 1/2, position correction of the tracking filter
+#define TRACKING_BETA_SHIFT 3 //beta = 1/8, velocity correction of the tracking filter
+#define TRACKING_MAXIMUM_MISSED_FRAMES 3 //The tracking filter predicts through up to this number of empty frames before the target is dropped.
 #define NOISE_LENGTH 1 //For consecutive readings that length is equal of less than this value, the readings are considered noise and omitted.
 
+#define GEOMETRY_FRACTION_BITS 14 //Result of FuzzyRadar::sine() and cosine(), 1 << GEOMETRY_FRACTION_BITS is 1.0
+#define FULL_TURN_DECIDEGREES 3600 //Angles of a ring array are reported from 0 to FULL_TURN_DECIDEGREES - 1, see setRingGeometry().
+
+#define ROI_MARGIN 2 //Adaptive region of interest: sensors polled on each side of the tracked target.
+#define ROI_FULL_SCAN_INTERVAL 8 //Adaptive region of interest: the whole array is polled every this number of frames.
+
+#define MAXIMUM_TARGETS 4 //Capacity of the multi-target buffer.
+#define TARGET_ASSOCIATION_ANGLE 15 //A target keeps its ID if it moved less than this (degrees) since the previous frame...
+#define TARGET_ASSOCIATION_DISTANCE 250 //...and less than this (mm).
+
+//Per-sensor state bits stored in sensorFlags[]
+#define SENSOR_FLAG_FRESH_SAMPLE 0x01 //A sample has been read for the frame being assembled.
+#define SENSOR_FLAG_CALIBRATED 0x02 //The current reference calibration step has completed during begin().
+#define SENSOR_FLAG_RESTORED 0x04 //The sensor was initialized from saved calibration data during begin().
+#define SENSOR_SAMPLE_STATUS_SHIFT 3 //Bits 3 to 5 of sensorFlags[] hold the SAMPLE_STATUS_* of the last sample.
+#define SENSOR_SAMPLE_STATUS_MASK 0x38
+#define SENSOR_PROFILE_SHIFT 6 //The upper two bits of sensorFlags[] hold the RangingProfile of the sensor.
+#define SENSOR_PROFILE_MASK 0xC0
+
+//Binary frame output, see setBinaryOutput()
+#define BINARY_FRAME_SYNC_0 0xA5
+#define BINARY_FRAME_SYNC_1 0x5A
+#define BINARY_FRAME_SIZE(n) (15 + 2 * (n) + ((n) + 1) / 2) //Bytes per frame for n sensors.
+
+//Sample status reported by setBinaryOutput() and RadarFrame. Statuses 4 to 7 need setSampleValidation().
+#define SAMPLE_STATUS_VALID 0
+#define SAMPLE_STATUS_NO_READING 1 //0, above the maximum range, or the 8190/8191 no target codes
+#define SAMPLE_STATUS_BUS_ERROR 2
+#define SAMPLE_STATUS_MISSING 3 //no sample in this frame (data-ready timeout, staggered phase not finished, outside of the scanned range)
+#define SAMPLE_STATUS_SIGNAL_FAIL 4 //device range status: return signal below the signal rate limit
+#define SAMPLE_STATUS_PHASE_FAIL 5 //device range status: phase out of the valid limits (wrap-around)
+#define SAMPLE_STATUS_DEVICE_ERROR 6 //device range status: hardware or minimum range fail
+#define SAMPLE_STATUS_LOW_CONFIDENCE 7 //signal rate below or ambient rate above the thresholds of setSampleValidation()
+
+//Sample validation defaults, see setSampleValidation()
+#define SAMPLE_MINIMUM_SIGNAL_RATE 0 //MCPS, 0 uses the signal rate limit of the ranging profile of each sensor
+#define SAMPLE_MAXIMUM_AMBIENT_RATE 4.0 //MCPS
+
+
+//Algorithm switches. Comment out to use the floating point version.
+#define FIXED_POINT_CENTROID //Weighted angle centroid in Q(CENTROID_FRACTION_BITS) fixed point, much faster on AVR (no software float).
+#define CENTROID_FRACTION_BITS 8
+#define TRACKING_FILTER //Constant-velocity alpha-beta filter on the output, instead of the single-pole IIR filter.
+
+
+//Instrumentation switch. Uncomment to collect frame timing, bus traffic and error counters, see getStatistics().
+//#define FUZZY_RADAR_INSTRUMENTATION
+#define STATISTICS_HISTOGRAM_BINS 8
+#define STATISTICS_HISTOGRAM_BIN_WIDTH 5000 //Width (us) of a frame latency histogram bin. The last bin collects everything above.
+
 
 //Debug switches for serial output. Comment out to disable the debug code.
 //#define DEBUG_PRINT_INITILAZATION_PROGRESS
@@ -39,47 +108,336 @@
 
 
 
+struct RadarTarget
+{
+	uint8_t id; //Stable across frames while the target is tracked. 0 is never used.
+	uint8_t startingSensorIndex;
+	uint8_t length; //Number of sensors in the group.
+	uint16_t meanDistance; //mm
+	int16_t angle; //0.1 degree units
+	int16_t x; //mm, see FuzzyRadar::getXMM()
+	int16_t y; //mm
+	uint8_t missedFrames; //0 when detected in this frame, else the frames since, up to TRACKING_MAXIMUM_MISSED_FRAMES
+};
+
+struct RadarFrame
+{
+	uint32_t timestamp; //millis() when the frame was published
+	uint16_t sequence; //incremented for every published frame, gaps are frames dropped on a full buffer
+	uint16_t distance; //filtered distance (mm)
+	int16_t angle; //filtered angle (0.1 degree)
+	int16_t x; //filtered position (mm), see FuzzyRadar::getXMM()
+	int16_t y;
+	uint8_t numberOfTargets; //0 unless multi-target tracking is enabled
+	RadarTarget targets[MAXIMUM_TARGETS];
+	int16_t *sampleDistance; //raw distance (mm) of each sensor before the deviation and noise filters
+	uint8_t *sampleStatus; //SAMPLE_STATUS_* of each sensor
+};
+
+/*
+Single-producer/single-consumer ring buffer of complete frames, see FuzzyRadar::setFrameBuffer().
+FuzzyRadar fills it from update(), the application drains it at its own pace:
+
+	StaticRadarFrameBuffer<9, 8> frames; //9 sensors, 8 frames
+	...
+	while (const RadarFrame *frame = frames.peek())
+	{
+		...
+		frames.pop();
+	}
+
+The producer only writes head and the consumer only writes tail, so no lock is needed
+when update() and the consumer run in different contexts (e.g. timer interrupt and loop()).
+A frame published while the buffer is full is dropped and counted in getOverruns().
+*/
+class RadarFrameBuffer
+{
+public:
+	uint8_t getNumberOfSensors();
+	uint8_t getCapacity();
+	uint8_t available();
+	const RadarFrame *peek();
+	void pop();
+	uint16_t getOverruns();
+
+	RadarFrame *claim();
+	void publish();
+
+protected:
+	RadarFrameBuffer(uint8_t _numberOfSensors, uint8_t _capacity, RadarFrame *_slots, int16_t *_sampleDistance, uint8_t *_sampleStatus);
+
+private:
+	RadarFrame *slots;
+	uint8_t numberOfSensors;
+	uint8_t numberOfSlots; //capacity + 1, one slot is always free to tell full from empty
+	volatile uint8_t head; //next slot to write, producer only
+	volatile uint8_t tail; //next slot to read, consumer only
+	volatile uint16_t overruns;
+};
+
+template <uint8_t N, uint8_t LENGTH>
+class StaticRadarFrameBuffer : public RadarFrameBuffer
+{
+	static_assert(LENGTH < 255, "LENGTH + 1 slots must fit the uint8_t slot count");
+
+public:
+	StaticRadarFrameBuffer()
+		:RadarFrameBuffer(N, LENGTH, slotBuffer, sampleDistanceBuffer, sampleStatusBuffer)
+	{
+	}
+
+private:
+	RadarFrame slotBuffer[LENGTH + 1];
+	int16_t sampleDistanceBuffer[(LENGTH + 1) * N];
+	uint8_t sampleStatusBuffer[(LENGTH + 1) * N];
+};
+
+#ifdef FUZZY_RADAR_INSTRUMENTATION
+struct RadarTimer
+{
+	uint32_t minimum; //us
+	uint32_t maximum; //us
+	uint32_t total; //us
+	uint32_t count;
+
+	uint32_t average() const { return (count == 0) ? 0 : total / count; }
+};
+
+struct RadarStatistics
+{
+	uint32_t frames;
+	RadarTimer busTime; //Time spent in I2C transactions during a frame.
+	RadarTimer acquisitionTime; //First bus transaction of a frame to the start of calculateData(), including waits between reads.
+	RadarTimer computeTime; //calculateData() up to the output filter.
+	RadarTimer outputTime; //DEBUG_PRINT_* output after the filter, 0 when disabled.
+	RadarTimer frameLatency; //First bus transaction of a frame to available().
+	uint32_t latencyHistogram[STATISTICS_HISTOGRAM_BINS];
+	uint32_t busBytes; //Register address and data bytes, I2C address bytes excluded.
+	uint32_t busErrors; //Transactions that ended with a non-zero last_status (NACK or bus error).
+	uint32_t timeouts; //Sensors that had no sample when their frame or phase was closed.
+};
+#endif //FUZZY_RADAR_INSTRUMENTATION
+
 class FuzzyRadar
 {
 public:
+	enum ReadMode
+	{
+		READ_MODE_TIMED,		//Read all sensors once per frame period, READ_DATA_DURATION ms by default (default).
+		READ_MODE_DATA_READY,	//Poll RESULT_INTERRUPT_STATUS, one sensor per update(), and publish a frame as soon as every sensor has a fresh sample.
+		READ_MODE_NON_BLOCKING	//Same timing as READ_MODE_TIMED, but each update() performs at most one I2C bus operation.
+	};
+
+	enum RangingProfile
+	{
+		RANGING_PROFILE_DEFAULT,		//Device defaults (33 ms timing budget), frame period READ_DATA_DURATION.
+		RANGING_PROFILE_HIGH_SPEED,		//20 ms timing budget, back-to-back ranging. Shorter range and more noise.
+		RANGING_PROFILE_LONG_RANGE,		//0.1 MCPS signal limit, 18/14 VCSEL periods. Up to ~2 m in the dark, more noise in ambient light.
+		RANGING_PROFILE_HIGH_ACCURACY	//200 ms timing budget.
+	};
+
+	enum AngleEstimator
+	{
+		ANGLE_ESTIMATOR_CENTROID,	//Distance-weighted centroid of the primary group (default).
+		ANGLE_ESTIMATOR_PARABOLIC,	//Parabolic fit through the closest reading and its neighbours.
+		ANGLE_ESTIMATOR_SIGNAL_WEIGHTED,	//Centroid weighted by the return signal rate of each sensor. Enables full frame read.
+		ANGLE_ESTIMATOR_SIGNAL_PER_SPAD	//Centroid weighted by the return signal rate per effective SPAD. Enables full frame read.
+	};
+
 	FuzzyRadar(uint8_t _numberOfSensors);
-	~FuzzyRadar();
-	void begin(uint8_t _xshutnPin, float _seperationDegrees);
+	virtual ~FuzzyRadar();
+	bool begin(uint8_t _xshutnPin, float _seperationDegrees);
+	bool begin(uint8_t _xshutnPin, const float *_azimuthDegrees);
 	void update();
 	int16_t getAngleDegree();
+	int16_t getAngleDecidegree();
 	uint16_t getDistanceMM();
+	int16_t getXMM();
+	int16_t getYMM();
+	void setMountingHeightMM(uint16_t _mountingHeight);
 	bool available();
 	void clearAvailableFlag();
 	void printRawData();
 	void setMaximumRangeMM(int16_t _maximumRange);
+	void setRingGeometry(bool _ringGeometry);
+	int16_t getSensorAngleDecidegree(uint8_t index);
+	static int16_t sine(int16_t angleDecidegrees);
+	static int16_t cosine(int16_t angleDecidegrees);
+	static int16_t atan2Decidegree(int32_t y, int32_t x);
+	void setBus(TwoWire *_bus);
+	bool setBus(uint8_t index, TwoWire *_bus);
+	bool setBuses(TwoWire * const *_buses, uint8_t _numberOfBuses);
+	uint8_t getNumberOfBuses();
+	bool setMultiplexer(uint8_t _multiplexerAddress, uint8_t _sensorsPerChannel);
+	void setFullFrameRead(bool _fullFrameRead);
+	VL53L0X::RangingData getRangingData(uint8_t index);
+	void setReadMode(ReadMode _readMode);
+	void setRangingPhases(uint8_t _rangingPhases, uint16_t _targetFramePeriodMS = 0);
+	void setRangingProfile(RangingProfile _rangingProfile);
+	void setRangingProfile(uint8_t index, RangingProfile _rangingProfile);
+	RangingProfile getRangingProfile(uint8_t index);
+	uint16_t getFramePeriodMS();
+	float getFrameRate();
+	uint16_t getSampleAgeMS(uint8_t index);
+	uint16_t getStartupTimeMS();
+	void setCalibrationData(const uint8_t *_calibrationData);
+	void getCalibrationData(uint8_t index, uint8_t *blob);
+	void setMultiTargetTracking(bool _multiTargetTracking);
+	void setAdaptiveRegionOfInterest(bool _adaptiveRegionOfInterest);
+	void setSampleValidation(bool _sampleValidation, float _minimumSignalRateMCPS = SAMPLE_MINIMUM_SIGNAL_RATE, float _maximumAmbientRateMCPS = SAMPLE_MAXIMUM_AMBIENT_RATE);
+	uint8_t getNumberOfTargets();
+	RadarTarget getTarget(uint8_t targetIndex);
+	int16_t getDistanceVelocity();
+	int16_t getAngleVelocity();
+	uint16_t getPredictedDistanceMM();
+	int16_t getPredictedAngleDegree();
+	int16_t getPredictedAngleDecidegree();
+	void setAngleEstimator(AngleEstimator _angleEstimator);
+	void setBinaryOutput(Print *_binaryOutput);
+	bool setFrameBuffer(RadarFrameBuffer *_frameBuffer);
+#ifdef FUZZY_RADAR_INSTRUMENTATION
+	const RadarStatistics &getStatistics();
+	void resetStatistics();
+#endif //FUZZY_RADAR_INSTRUMENTATION
+
+protected:
+	FuzzyRadar(uint8_t _numberOfSensors, VL53L0X *_sensor, uint8_t *_address, int16_t *_distance,
+		uint8_t *_sensorFlags, uint16_t *_sampleTime, VL53L0X::RangingData *_rangingData, uint8_t *_binaryFrame,
+		int16_t *_sensorAngle, int16_t *_heldDistance);
 
 private:
 	VL53L0X *sensor;
+	TwoWire *buses[MAXIMUM_BUSES];
+	uint8_t numberOfBuses;
+	uint8_t multiplexerAddress;
+	uint8_t sensorsPerChannel; //0 without a multiplexer
+	uint8_t selectedChannel[MAXIMUM_BUSES]; //Multiplexer channel enabled on each bus, 0xFF when unknown.
 	uint8_t *address;
 	uint8_t numberOfSensors;
+	bool ownsBuffers; //false when the per-sensor buffers belong to a StaticFuzzyRadar<N>
 	uint8_t xshutnPin;
 	int16_t *distance;
+	VL53L0X::RangingData *rangingData;
+	bool fullFrameRead;
+	uint8_t *sensorFlags;
+	ReadMode readMode;
+	uint8_t freshSampleCount;
+	uint8_t pollIndex; //Next sensor to poll in data-ready read mode.
+	bool sweepInProgress;
+	uint16_t laneIndex[MAXIMUM_BUSES]; //Sensor being read on each bus in non-blocking mode, past endingSensorIndex when the bus is done.
+	uint8_t currentLane; //Bus stepped by the last update() in non-blocking mode, the buses take turns.
+	uint8_t transactionBuffer[12]; //Data of the non-blocking read in progress, shared by the buses.
+	uint16_t *sampleTime;
+	int16_t *heldDistance; //Last sample of each sensor in staggered ranging, merged into the frames of the other phases.
+	uint8_t rangingPhases;
+	uint8_t currentPhase;
+	uint16_t targetFramePeriod;
+	uint16_t phaseDuration;
+	uint16_t readDuration;
+	uint32_t frameTimer;
+	uint16_t framePeriodRegister;
+	uint16_t startupTime;
+	const uint8_t *calibrationData;
+	bool multiTargetTracking;
+	bool adaptiveRegionOfInterest;
+	bool sampleValidation;
+	uint16_t minimumSignalRate; //MCPS, 9.7 fixed point like VL53L0X::RangingData, 0 for the limit of the ranging profile
+	uint16_t maximumAmbientRate;
+	uint8_t fullScanCounter;
+	AngleEstimator angleEstimator;
+	Print *binaryOutput;
+	uint8_t *binaryFrame;
+	uint16_t frameSequence;
+	RadarFrameBuffer *frameBuffer;
+	RadarFrame *pendingFrame;
+	RadarTarget targets[MAXIMUM_TARGETS];
+	uint8_t numberOfTargets;
+	uint8_t nextTargetId;
 	uint8_t numberOfReadings;
-	float seperation;
-	float startSensorOffset;
+	int16_t *sensorAngle; //Angle of each sensor (0.1 degree), the lookup table of indexToAngle(), filled by begin().
+	bool ringGeometry;
 	uint32_t total;
 	int16_t meanDistance;
+	int16_t angle; //0.1 degree units, as is every angle stored below
+#ifdef TRACKING_FILTER
+	int32_t distancePosition;
+	int32_t distanceVelocity;
+	int32_t anglePosition;
+	int32_t angleVelocity;
+	uint8_t trackingMissedFrames;
+#else
 	uint32_t meanDistanceRegister;
-	float *weight;
-	float weightedTotal;
-	float weightedIndex;
-	int16_t angle;
 	int32_t angleRegister;
+#endif //TRACKING_FILTER
 	uint16_t filteredMeanDistance;
 	int16_t filteredAngle;
+	int16_t filteredX;
+	int16_t filteredY;
+	uint16_t mountingHeight; //mm, 0 when the x/y position is not projected on the floor plane
 	uint8_t readingCounter;
 	uint32_t readDataTimer;
 	uint8_t startingSensorIndex;
 	uint8_t endingSensorIndex;
 	int16_t maximumRange;
+#ifdef FUZZY_RADAR_INSTRUMENTATION
+	RadarStatistics statistics;
+	bool frameStarted;
+	uint32_t frameStartTime;
+	uint32_t frameBusTime;
+	uint32_t computeStartTime;
+	uint32_t computeDoneTime;
+#endif //FUZZY_RADAR_INSTRUMENTATION
 
+	void initialize();
+	bool startSensors();
+	void setSensorAngle(uint8_t index, float angleDegrees);
 	void readData();
+	void readDataWhenReady();
+	void readDataNonBlocking();
+	void readDataStaggered();
+	void startPhase(uint8_t phase);
+	void updateFramePeriod();
+	uint32_t applyRangingProfile(uint8_t index);
+	void calibrateSensors(VL53L0X::refCalibrationType type);
+	void readSensor(uint8_t index);
+	uint8_t addBus(TwoWire *_bus);
+	uint16_t nextSensorOnBus(uint8_t lane, uint16_t index);
+	uint8_t getChannel(uint8_t index);
+	void selectChannel(uint8_t index);
+	uint8_t planAddress(uint8_t index);
+	void queueSensorRead(uint8_t index);
+	void completeSensorRead(uint8_t index);
 	void calculateData();
+#ifdef TRACKING_FILTER
+	void updateTrackingFilter(int32_t &position, int32_t &velocity, int16_t measurement);
+#endif //TRACKING_FILTER
+	int16_t calculateGroupAngle(uint8_t groupStartingIndex, uint8_t groupLength, uint16_t groupMeanDistance);
+	int16_t indexToAngle(int32_t indexFixed);
+	int16_t wrapAngle(int32_t angleDecidegrees);
+	int16_t getAngleDifference(int16_t angleA, int16_t angleB);
+	uint8_t getScanStartingIndex();
+	uint8_t ringIndex(uint16_t position);
+	static uint32_t weightedIndex(uint32_t weightedTotal, uint32_t weightTotal);
+	static int16_t decidegreesToDegrees(int16_t decidegrees);
+	void toCartesian(uint16_t range, int16_t angleDecidegrees, int16_t &x, int16_t &y);
+	static uint16_t squareRoot(uint32_t value);
+	void calculateTargets();
+	void updateRegionOfInterest();
+	void validateSample(uint8_t index);
+	uint8_t classifyRangingData(uint8_t index);
+	uint16_t getSampleConfidence(uint8_t index);
+	void setSampleStatus(uint8_t index, uint8_t status);
+	uint8_t getSampleStatus(uint8_t index);
+	void packBinarySamples();
+	void writeBinaryFrame();
+	static uint16_t crc16(const uint8_t *data, uint16_t length);
+#ifdef FUZZY_RADAR_INSTRUMENTATION
+	void recordBusTransfer(uint8_t index, uint8_t bytes, uint32_t startTime);
+	void recordTimer(RadarTimer &timer, uint32_t value);
+#endif //FUZZY_RADAR_INSTRUMENTATION
+	void addTarget(RadarTarget *detectedTargets, uint8_t &numberOfDetectedTargets, uint8_t groupStartingIndex, uint8_t groupLength, uint16_t groupMeanDistance);
+	void trackTargets(RadarTarget *detectedTargets, uint8_t numberOfDetectedTargets);
+	bool isInRegionOfInterest(const RadarTarget &target);
 	
 	void resetDataValues();
 	void calculateMeanDistance();
@@ -88,5 +446,40 @@ private:
 	
 };
 
+/*
+Same as FuzzyRadar, with the number of sensors fixed at compile time.
+All per-sensor buffers are members, so nothing is allocated on the heap:
+
+	StaticFuzzyRadar<9> radar;
+
+The RangingData buffer for setFullFrameRead() (9 bytes per sensor), the frame buffer
+for setBinaryOutput() (BINARY_FRAME_SIZE(N) bytes) and the sample buffer for setRangingPhases()
+(2 bytes per sensor) are always reserved.
+The destructor of FuzzyRadar is virtual, so an instance made with new can be deleted through a FuzzyRadar pointer.
+*/
+template <uint8_t N>
+class StaticFuzzyRadar : public FuzzyRadar
+{
+public:
+	StaticFuzzyRadar()
+		:FuzzyRadar(N, sensorBuffer, addressBuffer, distanceBuffer, sensorFlagsBuffer, sampleTimeBuffer, rangingDataBuffer, binaryFrameBuffer,
+			sensorAngleBuffer, heldDistanceBuffer)
+	{
+		memset(rangingDataBuffer, 0, sizeof(rangingDataBuffer));
+		memset(heldDistanceBuffer, 0, sizeof(heldDistanceBuffer));
+	}
+
+private:
+	VL53L0X sensorBuffer[N];
+	uint8_t addressBuffer[N];
+	int16_t distanceBuffer[N];
+	uint8_t sensorFlagsBuffer[N];
+	uint16_t sampleTimeBuffer[N];
+	VL53L0X::RangingData rangingDataBuffer[N];
+	uint8_t binaryFrameBuffer[BINARY_FRAME_SIZE(N)];
+	int16_t sensorAngleBuffer[N];
+	int16_t heldDistanceBuffer[N];
+};
+
 #endif
 
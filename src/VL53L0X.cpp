@@ -7,6 +7,7 @@
 This Pololu is modified by georgychen;
 - Added some regAddr values
 - Added setGPIO(bool true=high, false=low) function to set the GPIO output to high(pulled-up) or low.
+- Added setBus(TwoWire *) so the sensor can talk over any TwoWire instance instead of the global Wire.
 */
 
 #include "VL53L0X.h"
@@ -41,9 +42,11 @@ This Pololu is modified by georgychen;
 // Constructors ////////////////////////////////////////////////////////////////
 
 VL53L0X::VL53L0X(void)
-  : address(ADDRESS_DEFAULT)
+  : bus(&Wire)
+  , address(ADDRESS_DEFAULT)
   , io_timeout(0) // no timeout
   , did_timeout(false)
+  , transaction_state(TransactionIdle)
 {
 }
 
@@ -65,33 +68,41 @@ void VL53L0X::setAddress(uint8_t new_addr)
 // mode.
 bool VL53L0X::init(bool io_2v8)
 {
-  // VL53L0X_DataInit() begin
+  if (!initWithoutCalibration(io_2v8)) { return false; }
 
-  // sensor uses 1V8 mode for I/O by default; switch to 2V8 mode if necessary
-  if (io_2v8)
-  {
-    writeReg(VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV,
-      readReg(VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV) | 0x01); // set bit 0
-  }
+  // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
 
-  // "Set I2C standard mode"
-  writeReg(0x88, 0x00);
+  // -- VL53L0X_perform_vhv_calibration() begin
 
-  writeReg(0x80, 0x01);
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-  stop_variable = readReg(0x91);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
+  if (!performSingleRefCalibration(0x40)) { return false; }
 
-  // disable SIGNAL_RATE_MSRC (bit 1) and SIGNAL_RATE_PRE_RANGE (bit 4) limit checks
-  writeReg(MSRC_CONFIG_CONTROL, readReg(MSRC_CONFIG_CONTROL) | 0x12);
+  // -- VL53L0X_perform_vhv_calibration() end
 
-  // set final range signal rate limit to 0.25 MCPS (million counts per second)
-  setSignalRateLimit(0.25);
+  // -- VL53L0X_perform_phase_calibration() begin
 
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xFF);
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
+  if (!performSingleRefCalibration(0x00)) { return false; }
+
+  // -- VL53L0X_perform_phase_calibration() end
+
+  // "restore the previous Sequence Config"
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
+
+  // VL53L0X_PerformRefCalibration() end
+
+  return true;
+}
+
+// The VL53L0X_DataInit() and VL53L0X_StaticInit() part of init(). The sensor
+// still needs its VHV and phase reference calibration before ranging; either
+// call init() instead, or run startRefCalibration()/refCalibrationDone()/
+// finishRefCalibration() so calibrations of several sensors can overlap.
+bool VL53L0X::initWithoutCalibration(bool io_2v8)
+{
+  // VL53L0X_DataInit() begin
+
+  dataInit(io_2v8, true);
 
   // VL53L0X_DataInit() end
 
@@ -136,184 +147,168 @@ bool VL53L0X::init(bool io_2v8)
 
   // -- VL53L0X_set_reference_spads() end
 
-  // -- VL53L0X_load_tuning_settings() begin
-  // DefaultTuningSettings from vl53l0x_tuning.h
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
+  loadTuningSettings();
 
-  writeReg(0xFF, 0x00);
-  writeReg(0x09, 0x00);
-  writeReg(0x10, 0x00);
-  writeReg(0x11, 0x00);
-
-  writeReg(0x24, 0x01);
-  writeReg(0x25, 0xFF);
-  writeReg(0x75, 0x00);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x4E, 0x2C);
-  writeReg(0x48, 0x00);
-  writeReg(0x30, 0x20);
+  measurement_timing_budget_us = getMeasurementTimingBudget();
 
-  writeReg(0xFF, 0x00);
-  writeReg(0x30, 0x09);
-  writeReg(0x54, 0x00);
-  writeReg(0x31, 0x04);
-  writeReg(0x32, 0x03);
-  writeReg(0x40, 0x83);
-  writeReg(0x46, 0x25);
-  writeReg(0x60, 0x00);
-  writeReg(0x27, 0x00);
-  writeReg(0x50, 0x06);
-  writeReg(0x51, 0x00);
-  writeReg(0x52, 0x96);
-  writeReg(0x56, 0x08);
-  writeReg(0x57, 0x30);
-  writeReg(0x61, 0x00);
-  writeReg(0x62, 0x00);
-  writeReg(0x64, 0x00);
-  writeReg(0x65, 0x00);
-  writeReg(0x66, 0xA0);
+  // "Disable MSRC and TCC by default"
+  // MSRC = Minimum Signal Rate Check
+  // TCC = Target CentreCheck
+  // -- VL53L0X_SetSequenceStepEnable() begin
 
-  writeReg(0xFF, 0x01);
-  writeReg(0x22, 0x32);
-  writeReg(0x47, 0x14);
-  writeReg(0x49, 0xFF);
-  writeReg(0x4A, 0x00);
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
 
-  writeReg(0xFF, 0x00);
-  writeReg(0x7A, 0x0A);
-  writeReg(0x7B, 0x00);
-  writeReg(0x78, 0x21);
+  // -- VL53L0X_SetSequenceStepEnable() end
 
-  writeReg(0xFF, 0x01);
-  writeReg(0x23, 0x34);
-  writeReg(0x42, 0x00);
-  writeReg(0x44, 0xFF);
-  writeReg(0x45, 0x26);
-  writeReg(0x46, 0x05);
-  writeReg(0x40, 0x40);
-  writeReg(0x0E, 0x06);
-  writeReg(0x20, 0x1A);
-  writeReg(0x43, 0x40);
+  // "Recalculate timing budget"
+  setMeasurementTimingBudget(measurement_timing_budget_us);
 
-  writeReg(0xFF, 0x00);
-  writeReg(0x34, 0x03);
-  writeReg(0x35, 0x44);
+  // VL53L0X_StaticInit() end
 
-  writeReg(0xFF, 0x01);
-  writeReg(0x31, 0x04);
-  writeReg(0x4B, 0x09);
-  writeReg(0x4C, 0x05);
-  writeReg(0x4D, 0x04);
+  return true;
+}
 
-  writeReg(0xFF, 0x00);
-  writeReg(0x44, 0x00);
-  writeReg(0x45, 0x20);
-  writeReg(0x47, 0x08);
-  writeReg(0x48, 0x28);
-  writeReg(0x67, 0x00);
-  writeReg(0x70, 0x04);
-  writeReg(0x71, 0x01);
-  writeReg(0x72, 0xFE);
-  writeReg(0x76, 0x00);
-  writeReg(0x77, 0x00);
+// Save the resolved configuration of an initialized sensor (I2C address,
+// stop_variable, reference SPAD map, VHV and phase calibration, timing budget)
+// into a CalibrationDataSize-byte blob, so a later boot can restore it with
+// initFromCalibrationData() instead of running init().
+//
+// Blob layout: [0] format version, [1] address, [2] stop_variable,
+// [3..8] reference SPAD map, [9] VHV settings, [10] phase calibration,
+// [11..14] timing budget in us (MSB first), [15] CRC-8 of bytes 0..14
+void VL53L0X::getCalibrationData(uint8_t * blob)
+{
+  blob[0] = CalibrationDataVersion;
+  blob[1] = address;
+  blob[2] = stop_variable;
+  readMulti(GLOBAL_CONFIG_SPAD_ENABLES_REF_0, blob + 3, 6);
 
+  // based on VL53L0X_ref_calibration_io() (read)
   writeReg(0xFF, 0x01);
-  writeReg(0x0D, 0x01);
-
+  writeReg(0x00, 0x00);
   writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x01);
-  writeReg(0x01, 0xF8);
-
+  blob[9]  = readReg(0xCB);
+  blob[10] = readReg(0xEE);
   writeReg(0xFF, 0x01);
-  writeReg(0x8E, 0x01);
   writeReg(0x00, 0x01);
   writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
 
-  // -- VL53L0X_load_tuning_settings() end
-
-  // "Set interrupt config to new sample ready"
-  // -- VL53L0X_SetGpioConfig() begin
+  blob[11] = (measurement_timing_budget_us >> 24) & 0xFF;
+  blob[12] = (measurement_timing_budget_us >> 16) & 0xFF;
+  blob[13] = (measurement_timing_budget_us >>  8) & 0xFF;
+  blob[14] =  measurement_timing_budget_us        & 0xFF;
 
+  blob[15] = calibrationChecksum(blob);
+}
 
-  writeReg(SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04);
-  writeReg(GPIO_HV_MUX_ACTIVE_HIGH, readReg(GPIO_HV_MUX_ACTIVE_HIGH) & ~0x10); // active low
-  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+// Warm-start alternative to init(): runs the same DataInit/StaticInit register
+// sequence, but takes stop_variable, the reference SPAD map and the VHV/phase
+// calibration from a blob saved by getCalibrationData() instead of reading
+// them out of NVM and measuring them. Returns false without touching the
+// sensor if the blob is corrupt, from another format version, or was saved
+// for a different I2C address; the caller should then fall back to init().
+bool VL53L0X::initFromCalibrationData(uint8_t const * blob, bool io_2v8)
+{
+  if (blob[0] != CalibrationDataVersion) { return false; }
+  if (blob[15] != calibrationChecksum(blob)) { return false; }
+  if (blob[1] != address) { return false; }
 
-  // -- VL53L0X_SetGpioConfig() end
+  stop_variable = blob[2];
+  dataInit(io_2v8, false);
 
-  measurement_timing_budget_us = getMeasurementTimingBudget();
+  // -- VL53L0X_set_reference_spads() begin (map restored from the blob)
 
-  // "Disable MSRC and TCC by default"
-  // MSRC = Minimum Signal Rate Check
-  // TCC = Target CentreCheck
-  // -- VL53L0X_SetSequenceStepEnable() begin
-
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
-
-  // -- VL53L0X_SetSequenceStepEnable() end
+  writeReg(0xFF, 0x01);
+  writeReg(DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00);
+  writeReg(DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C);
+  writeReg(0xFF, 0x00);
+  writeReg(GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4);
+  writeMulti(GLOBAL_CONFIG_SPAD_ENABLES_REF_0, blob + 3, 6);
 
-  // "Recalculate timing budget"
-  setMeasurementTimingBudget(measurement_timing_budget_us);
+  // -- VL53L0X_set_reference_spads() end
 
-  // VL53L0X_StaticInit() end
+  loadTuningSettings();
 
-  // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
 
-  // -- VL53L0X_perform_vhv_calibration() begin
+  setMeasurementTimingBudget(((uint32_t)blob[11] << 24) | ((uint32_t)blob[12] << 16) |
+                             ((uint32_t)blob[13] <<  8) |            blob[14]);
 
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
-  if (!performSingleRefCalibration(0x40)) { return false; }
+  // based on VL53L0X_ref_calibration_io() (write)
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0xFF, 0x00);
+  writeReg(0xCB, (readReg(0xCB) & 0x80) | (blob[9]  & 0x7F));
+  writeReg(0xEE, (readReg(0xEE) & 0x80) | (blob[10] & 0x7F));
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
 
-  // -- VL53L0X_perform_vhv_calibration() end
+  return true;
+}
 
-  // -- VL53L0X_perform_phase_calibration() begin
+// Start one reference calibration step without waiting for it to complete.
+// Poll refCalibrationDone(), then call finishRefCalibration().
+// based on VL53L0X_perform_vhv_calibration() and
+// VL53L0X_perform_phase_calibration()
+void VL53L0X::startRefCalibration(refCalibrationType type)
+{
+  if (type == RefCalibrationVhv)
+  {
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
+    writeReg(SYSRANGE_START, 0x01 | 0x40); // VL53L0X_REG_SYSRANGE_MODE_START_STOP
+  }
+  else
+  {
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
+    writeReg(SYSRANGE_START, 0x01 | 0x00); // VL53L0X_REG_SYSRANGE_MODE_START_STOP
+  }
+}
 
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
-  if (!performSingleRefCalibration(0x00)) { return false; }
+bool VL53L0X::refCalibrationDone(void)
+{
+  return (readReg(RESULT_INTERRUPT_STATUS) & 0x07) != 0;
+}
 
-  // -- VL53L0X_perform_phase_calibration() end
+// Clear the calibration interrupt and restore the sequence config
+void VL53L0X::finishRefCalibration(void)
+{
+  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+  writeReg(SYSRANGE_START, 0x00);
 
   // "restore the previous Sequence Config"
   writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
-
-  // VL53L0X_PerformRefCalibration() end
-
-  return true;
 }
 
 // Write an 8-bit register
 void VL53L0X::writeReg(uint8_t reg, uint8_t value)
 {
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  Wire.write(value);
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  bus->write(value);
+  last_status = bus->endTransmission();
 }
 
 // Write a 16-bit register
 void VL53L0X::writeReg16Bit(uint8_t reg, uint16_t value)
 {
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  Wire.write((value >> 8) & 0xFF); // value high byte
-  Wire.write( value       & 0xFF); // value low byte
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  bus->write((value >> 8) & 0xFF); // value high byte
+  bus->write( value       & 0xFF); // value low byte
+  last_status = bus->endTransmission();
 }
 
 // Write a 32-bit register
 void VL53L0X::writeReg32Bit(uint8_t reg, uint32_t value)
 {
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  Wire.write((value >> 24) & 0xFF); // value highest byte
-  Wire.write((value >> 16) & 0xFF);
-  Wire.write((value >>  8) & 0xFF);
-  Wire.write( value        & 0xFF); // value lowest byte
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  bus->write((value >> 24) & 0xFF); // value highest byte
+  bus->write((value >> 16) & 0xFF);
+  bus->write((value >>  8) & 0xFF);
+  bus->write( value        & 0xFF); // value lowest byte
+  last_status = bus->endTransmission();
 }
 
 // Read an 8-bit register
@@ -321,12 +316,12 @@ uint8_t VL53L0X::readReg(uint8_t reg)
 {
   uint8_t value;
 
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  last_status = bus->endTransmission();
 
-  Wire.requestFrom(address, (uint8_t)1);
-  value = Wire.read();
+  bus->requestFrom(address, (uint8_t)1);
+  value = bus->read();
 
   return value;
 }
@@ -336,13 +331,13 @@ uint16_t VL53L0X::readReg16Bit(uint8_t reg)
 {
   uint16_t value;
 
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  last_status = bus->endTransmission();
 
-  Wire.requestFrom(address, (uint8_t)2);
-  value  = (uint16_t)Wire.read() << 8; // value high byte
-  value |=           Wire.read();      // value low byte
+  bus->requestFrom(address, (uint8_t)2);
+  value  = (uint16_t)bus->read() << 8; // value high byte
+  value |=           bus->read();      // value low byte
 
   return value;
 }
@@ -352,15 +347,15 @@ uint32_t VL53L0X::readReg32Bit(uint8_t reg)
 {
   uint32_t value;
 
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  last_status = bus->endTransmission();
 
-  Wire.requestFrom(address, (uint8_t)4);
-  value  = (uint32_t)Wire.read() << 24; // value highest byte
-  value |= (uint32_t)Wire.read() << 16;
-  value |= (uint16_t)Wire.read() <<  8;
-  value |=           Wire.read();       // value lowest byte
+  bus->requestFrom(address, (uint8_t)4);
+  value  = (uint32_t)bus->read() << 24; // value highest byte
+  value |= (uint32_t)bus->read() << 16;
+  value |= (uint16_t)bus->read() <<  8;
+  value |=           bus->read();       // value lowest byte
 
   return value;
 }
@@ -369,30 +364,30 @@ uint32_t VL53L0X::readReg32Bit(uint8_t reg)
 // starting at the given register
 void VL53L0X::writeMulti(uint8_t reg, uint8_t const * src, uint8_t count)
 {
-  Wire.beginTransmission(address);
-  Wire.write(reg);
+  bus->beginTransmission(address);
+  bus->write(reg);
 
   while (count-- > 0)
   {
-    Wire.write(*(src++));
+    bus->write(*(src++));
   }
 
-  last_status = Wire.endTransmission();
+  last_status = bus->endTransmission();
 }
 
 // Read an arbitrary number of bytes from the sensor, starting at the given
 // register, into the given array
 void VL53L0X::readMulti(uint8_t reg, uint8_t * dst, uint8_t count)
 {
-  Wire.beginTransmission(address);
-  Wire.write(reg);
-  last_status = Wire.endTransmission();
+  bus->beginTransmission(address);
+  bus->write(reg);
+  last_status = bus->endTransmission();
 
-  Wire.requestFrom(address, count);
+  bus->requestFrom(address, count);
 
   while (count-- > 0)
   {
-    *(dst++) = Wire.read();
+    *(dst++) = bus->read();
   }
 }
 
@@ -838,10 +833,10 @@ uint16_t VL53L0X::readRangeContinuousMillimeters(void)
   return range;
 }
 
-// Performs a single-shot range measurement and returns the reading in
-// millimeters
-// based on VL53L0X_PerformSingleRangingMeasurement()
-uint16_t VL53L0X::readRangeSingleMillimeters(void)
+// Starts a single-shot range measurement without waiting for it. The result
+// is signalled through RESULT_INTERRUPT_STATUS like a continuous measurement.
+// based on VL53L0X_StartMeasurement()
+void VL53L0X::startSingle(void)
 {
   writeReg(0x80, 0x01);
   writeReg(0xFF, 0x01);
@@ -851,7 +846,15 @@ uint16_t VL53L0X::readRangeSingleMillimeters(void)
   writeReg(0xFF, 0x00);
   writeReg(0x80, 0x00);
 
-  writeReg(SYSRANGE_START, 0x01);
+  writeReg(SYSRANGE_START, 0x01); // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
+}
+
+// Performs a single-shot range measurement and returns the reading in
+// millimeters
+// based on VL53L0X_PerformSingleRangingMeasurement()
+uint16_t VL53L0X::readRangeSingleMillimeters(void)
+{
+  startSingle();
 
   // "Wait until start bit has been cleared"
   startTimeout();
@@ -867,6 +870,73 @@ uint16_t VL53L0X::readRangeSingleMillimeters(void)
   return readRangeContinuousMillimeters();
 }
 
+// Reads the whole 12-byte RESULT_RANGE_STATUS block in a single burst and
+// decodes it. Unlike readRangeContinuousMillimeters(), this does not wait for
+// or clear the data-ready interrupt; it returns whatever the last completed
+// measurement left in the result registers.
+// based on VL53L0X_GetRangingMeasurementData()
+void VL53L0X::readRangingData(RangingData * data)
+{
+  uint8_t buffer[12];
+
+  readMulti(RESULT_RANGE_STATUS, buffer, 12);
+  decodeRangingData(buffer, data);
+}
+
+// Decode a raw 12-byte RESULT_RANGE_STATUS block
+void VL53L0X::decodeRangingData(uint8_t const * src, RangingData * data)
+{
+  data->range_status             = src[0];
+  data->effective_spad_rtn_count = ((uint16_t)src[2] << 8) | src[3];
+  data->signal_rate              = ((uint16_t)src[6] << 8) | src[7];
+  data->ambient_rate             = ((uint16_t)src[8] << 8) | src[9];
+  data->range_mm                 = ((uint16_t)src[10] << 8) | src[11];
+}
+
+// Queue a read of count bytes starting at reg into dst without touching the
+// bus. The read is then carried out by repeated calls to stepTransaction(), so
+// the caller never blocks for more than one bus operation at a time.
+void VL53L0X::queueReadMulti(uint8_t reg, uint8_t * dst, uint8_t count)
+{
+  transaction_reg = reg;
+  transaction_dst = dst;
+  transaction_count = count;
+  transaction_state = TransactionSetRegister;
+}
+
+// Perform the next bus operation of the queued read: first the register
+// pointer write, then the data request. Returns true once the read is
+// complete (or has failed; check last_status), false while it is pending or
+// when nothing is queued.
+bool VL53L0X::stepTransaction(void)
+{
+  switch (transaction_state)
+  {
+    case TransactionSetRegister:
+      bus->beginTransmission(address);
+      bus->write(transaction_reg);
+      last_status = bus->endTransmission();
+      // a NACKed register write ends the transaction; last_status holds the error
+      transaction_state = (last_status == 0) ? TransactionRequest : TransactionDone;
+      return (transaction_state == TransactionDone);
+
+    case TransactionRequest:
+      bus->requestFrom(address, transaction_count);
+      while (transaction_count-- > 0)
+      {
+        *(transaction_dst++) = bus->read();
+      }
+      transaction_state = TransactionDone;
+      return true;
+
+    case TransactionDone:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 // Did a timeout occur in one of the read functions since the last call to
 // timeoutOccurred()?
 bool VL53L0X::timeoutOccurred()
@@ -1024,6 +1094,170 @@ uint32_t VL53L0X::timeoutMicrosecondsToMclks(uint32_t timeout_period_us, uint8_t
 }
 
 
+// VL53L0X_DataInit() part of the initialization. stop_variable is read from the
+// sensor only if read_stop_variable is true; otherwise it must already be set.
+void VL53L0X::dataInit(bool io_2v8, bool read_stop_variable)
+{
+  // sensor uses 1V8 mode for I/O by default; switch to 2V8 mode if necessary
+  if (io_2v8)
+  {
+    writeReg(VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV,
+      readReg(VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV) | 0x01); // set bit 0
+  }
+
+  // "Set I2C standard mode"
+  writeReg(0x88, 0x00);
+
+  if (read_stop_variable)
+  {
+    writeReg(0x80, 0x01);
+    writeReg(0xFF, 0x01);
+    writeReg(0x00, 0x00);
+    stop_variable = readReg(0x91);
+    writeReg(0x00, 0x01);
+    writeReg(0xFF, 0x00);
+    writeReg(0x80, 0x00);
+  }
+
+  // disable SIGNAL_RATE_MSRC (bit 1) and SIGNAL_RATE_PRE_RANGE (bit 4) limit checks
+  writeReg(MSRC_CONFIG_CONTROL, readReg(MSRC_CONFIG_CONTROL) | 0x12);
+
+  // set final range signal rate limit to 0.25 MCPS (million counts per second)
+  setSignalRateLimit(0.25);
+
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xFF);
+}
+
+// DefaultTuningSettings and GPIO configuration part of VL53L0X_StaticInit()
+void VL53L0X::loadTuningSettings(void)
+{
+  // -- VL53L0X_load_tuning_settings() begin
+  // DefaultTuningSettings from vl53l0x_tuning.h
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x09, 0x00);
+  writeReg(0x10, 0x00);
+  writeReg(0x11, 0x00);
+
+  writeReg(0x24, 0x01);
+  writeReg(0x25, 0xFF);
+  writeReg(0x75, 0x00);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x4E, 0x2C);
+  writeReg(0x48, 0x00);
+  writeReg(0x30, 0x20);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x30, 0x09);
+  writeReg(0x54, 0x00);
+  writeReg(0x31, 0x04);
+  writeReg(0x32, 0x03);
+  writeReg(0x40, 0x83);
+  writeReg(0x46, 0x25);
+  writeReg(0x60, 0x00);
+  writeReg(0x27, 0x00);
+  writeReg(0x50, 0x06);
+  writeReg(0x51, 0x00);
+  writeReg(0x52, 0x96);
+  writeReg(0x56, 0x08);
+  writeReg(0x57, 0x30);
+  writeReg(0x61, 0x00);
+  writeReg(0x62, 0x00);
+  writeReg(0x64, 0x00);
+  writeReg(0x65, 0x00);
+  writeReg(0x66, 0xA0);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x22, 0x32);
+  writeReg(0x47, 0x14);
+  writeReg(0x49, 0xFF);
+  writeReg(0x4A, 0x00);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x7A, 0x0A);
+  writeReg(0x7B, 0x00);
+  writeReg(0x78, 0x21);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x23, 0x34);
+  writeReg(0x42, 0x00);
+  writeReg(0x44, 0xFF);
+  writeReg(0x45, 0x26);
+  writeReg(0x46, 0x05);
+  writeReg(0x40, 0x40);
+  writeReg(0x0E, 0x06);
+  writeReg(0x20, 0x1A);
+  writeReg(0x43, 0x40);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x34, 0x03);
+  writeReg(0x35, 0x44);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x31, 0x04);
+  writeReg(0x4B, 0x09);
+  writeReg(0x4C, 0x05);
+  writeReg(0x4D, 0x04);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x44, 0x00);
+  writeReg(0x45, 0x20);
+  writeReg(0x47, 0x08);
+  writeReg(0x48, 0x28);
+  writeReg(0x67, 0x00);
+  writeReg(0x70, 0x04);
+  writeReg(0x71, 0x01);
+  writeReg(0x72, 0xFE);
+  writeReg(0x76, 0x00);
+  writeReg(0x77, 0x00);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x0D, 0x01);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x80, 0x01);
+  writeReg(0x01, 0xF8);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x8E, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
+  writeReg(0x80, 0x00);
+
+  // -- VL53L0X_load_tuning_settings() end
+
+  // "Set interrupt config to new sample ready"
+  // -- VL53L0X_SetGpioConfig() begin
+
+  writeReg(SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04);
+  writeReg(GPIO_HV_MUX_ACTIVE_HIGH, readReg(GPIO_HV_MUX_ACTIVE_HIGH) & ~0x10); // active low
+  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+
+  // -- VL53L0X_SetGpioConfig() end
+}
+
+// CRC-8 (polynomial 0x07) over the first CalibrationDataSize - 1 bytes of a
+// calibration blob
+uint8_t VL53L0X::calibrationChecksum(uint8_t const * blob)
+{
+  uint8_t crc = 0;
+
+  for (uint8_t i = 0; i < CalibrationDataSize - 1; i++)
+  {
+    crc ^= blob[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
 // based on VL53L0X_perform_single_ref_calibration()
 bool VL53L0X::performSingleRefCalibration(uint8_t vhv_init_byte)
 {
@@ -2,6 +2,7 @@
 #define VL53L0X_h
 
 #include <Arduino.h>
+#include <Wire.h>
 
 class VL53L0X
 {
@@ -98,14 +99,40 @@ class VL53L0X
 
     enum vcselPeriodType { VcselPeriodPreRange, VcselPeriodFinalRange };
 
+    static const uint8_t CalibrationDataSize = 16;
+    static const uint8_t CalibrationDataVersion = 0x01;
+
+    enum refCalibrationType { RefCalibrationVhv, RefCalibrationPhase };
+
+    enum transactionState { TransactionIdle, TransactionSetRegister, TransactionRequest, TransactionDone };
+
+    // decoded RESULT_RANGE_STATUS block, as read by VL53L0X_GetRangingMeasurementData()
+    struct RangingData
+    {
+      uint8_t range_status;              // raw device range status byte; ((range_status & 0x78) >> 3) == 11 is a valid range
+      uint16_t effective_spad_rtn_count; // 8.8 fixed point
+      uint16_t signal_rate;              // return signal rate in MCPS, 9.7 fixed point
+      uint16_t ambient_rate;             // return ambient rate in MCPS, 9.7 fixed point
+      uint16_t range_mm;
+    };
+
     uint8_t last_status; // status of last I2C transmission
 
     VL53L0X(void);
 
+    inline void setBus(TwoWire * new_bus) { bus = new_bus; }
+    inline TwoWire * getBus(void) { return bus; }
+
     void setAddress(uint8_t new_addr);
     inline uint8_t getAddress(void) { return address; }
 
     bool init(bool io_2v8 = true);
+    bool initWithoutCalibration(bool io_2v8 = true);
+    void startRefCalibration(refCalibrationType type);
+    bool refCalibrationDone(void);
+    void finishRefCalibration(void);
+    void getCalibrationData(uint8_t * blob);
+    bool initFromCalibrationData(uint8_t const * blob, bool io_2v8 = true);
 
     void writeReg(uint8_t reg, uint8_t value);
     void writeReg16Bit(uint8_t reg, uint16_t value);
@@ -128,8 +155,15 @@ class VL53L0X
 
     void startContinuous(uint32_t period_ms = 0);
     void stopContinuous(void);
+    void startSingle(void);
     uint16_t readRangeContinuousMillimeters(void);
     uint16_t readRangeSingleMillimeters(void);
+    void readRangingData(RangingData * data);
+    static void decodeRangingData(uint8_t const * src, RangingData * data);
+
+    void queueReadMulti(uint8_t reg, uint8_t * dst, uint8_t count);
+    bool stepTransaction(void);
+    inline transactionState getTransactionState(void) { return transaction_state; }
 
     inline void setTimeout(uint16_t timeout) { io_timeout = timeout; }
     inline uint16_t getTimeout(void) { return io_timeout; }
@@ -155,16 +189,26 @@ class VL53L0X
       uint32_t msrc_dss_tcc_us,    pre_range_us,    final_range_us;
     };
 
+    TwoWire * bus;
     uint8_t address;
     uint16_t io_timeout;
     bool did_timeout;
     uint16_t timeout_start_ms;
 
+    transactionState transaction_state;
+    uint8_t transaction_reg;
+    uint8_t * transaction_dst;
+    uint8_t transaction_count;
+
     uint8_t stop_variable; // read by init and used when starting measurement; is StopVariable field of VL53L0X_DevData_t structure in API
     uint32_t measurement_timing_budget_us;
 
     bool getSpadInfo(uint8_t * count, bool * type_is_aperture);
 
+    void dataInit(bool io_2v8, bool read_stop_variable);
+    void loadTuningSettings(void);
+    static uint8_t calibrationChecksum(uint8_t const * blob);
+
     void getSequenceStepEnables(SequenceStepEnables * enables);
     void getSequenceStepTimeouts(SequenceStepEnables const * enables, SequenceStepTimeouts * timeouts);
 